@@ -45,6 +45,7 @@
 #include "allocation.h"
 #include "floorplan.h"
 #include "array.h"
+#include "random.h"
 
 /* global variables declaration									*/
 floorplan *gfp					; /* global floorplan database	*/
@@ -55,6 +56,11 @@ float	   gWorldX				; /* world X dimension			*/
 float	   gWorldY				; /* world X dimension			*/
 
 
+/* move effort presets, multiplied by (cells#)^(4/3)			*/
+#define EFFORT_FAST		1		/* quick placement				*/
+#define EFFORT_NORMAL	10		/* VPR default inner_num		*/
+#define EFFORT_HIGH		100		/* quality runs					*/
+
 /* commandline arguments parsing, sets global variables			*/
 /* returns filename index in argv								*/
 unsigned int commandlineParse(int argc, char *argv[]			);
@@ -66,16 +72,28 @@ unsigned int gRefreshRate = 10	; /* refresh rate / temp change	*/
 double       gInitTemp    = 200	; /* initial temperature		*/
 double       gFreezeTemp  = 5e-6; /* freezing temperature		*/
 double       gCoolRate    = 0.95; /* cooling rate				*/
-unsigned int gMoveTemp    = 10	; /* moves per temperature		*/
+double       gMoveTemp    = 10	; /* moves/temp, x cells^(4/3)	*/
+unsigned int gRangeLimit  = 0	; /* swap window, 0: whole grid	*/
+double       gAcceptTarget= 0.44; /* range limiter target rate	*/
+int          gEquilibrium = 0	; /* equilibrium detection		*/
+unsigned int gNoImprove   = 0	; /* temps without improvement	*/
+int          gQuench      = 0	; /* final greedy quench		*/
+double       gTimeBudget  = 0	; /* wall-clock budget, seconds	*/
+double       gShiftProb   = 0.1	; /* shift moves probability	*/
+double       gDirectedProb= 0	; /* directed moves final prob.	*/
+int          gBandit      = 0	; /* adaptive move types mix	*/
+unsigned int gThreads     = 1	; /* multi-start annealers		*/
+unsigned long gSeed       = 0	; /* random seed				*/
+int          gParallel    = 0	; /* parallel engine, 0: none	*/
 
 /* functions associated with buttons																	*/
-inline void enablePS (void (*drawScreen_ptr)(void)) {gPostScript=1        ;} /* enable  postscript		*/
-inline void disablePS(void (*drawScreen_ptr)(void)) {gPostScript=0        ;} /* disable postscript		*/
-inline void run1     (void (*drawScreen_ptr)(void)) {gRefreshRate=1       ;} /* refresh every 1 temp	*/
-inline void run10    (void (*drawScreen_ptr)(void)) {gRefreshRate=10      ;} /* refresh every 10 temp	*/
-inline void run100   (void (*drawScreen_ptr)(void)) {gRefreshRate=100     ;} /* refresh every 100 temp	*/
-inline void run1000  (void (*drawScreen_ptr)(void)) {gRefreshRate=1000    ;} /* refresh every 1000 temp	*/
-inline void runAll   (void (*drawScreen_ptr)(void)) {gRefreshRate=UINT_MAX;} /* refresh at end only		*/
+static void enablePS (void (*drawScreen_ptr)(void)) {gPostScript=1        ;} /* enable  postscript		*/
+static void disablePS(void (*drawScreen_ptr)(void)) {gPostScript=0        ;} /* disable postscript		*/
+static void run1     (void (*drawScreen_ptr)(void)) {gRefreshRate=1       ;} /* refresh every 1 temp	*/
+static void run10    (void (*drawScreen_ptr)(void)) {gRefreshRate=10      ;} /* refresh every 10 temp	*/
+static void run100   (void (*drawScreen_ptr)(void)) {gRefreshRate=100     ;} /* refresh every 100 temp	*/
+static void run1000  (void (*drawScreen_ptr)(void)) {gRefreshRate=1000    ;} /* refresh every 1000 temp	*/
+static void runAll   (void (*drawScreen_ptr)(void)) {gRefreshRate=UINT_MAX;} /* refresh at end only		*/
 
 /* redrawing routine for still pictures. Redraw if user changes the window								*/
 void drawScreen () { clearscreen(); fpDraw(gfp,gWorldX,gWorldY); } /* clear and redraw					*/
@@ -101,15 +119,25 @@ void waitLoop () {
 
 int main(int argc, char *argv[]) {
 
-	/* parse commandline returns filename index in argv */
-	/* create floorplan data structure					*/
-	gfp=fpCreate(argv[commandlineParse(argc,argv)]);
+	int			 fileNameInd;	/* file name argument index		*/
+	unsigned int movesPerTemp;	/* moves per temperature		*/
+	double		 initTemp;		/* initial temperature			*/
+	double		 freezingTemp;	/* freezing temperature			*/
+
+	/* random seed is the current time, unless set by -seed */
+	gSeed = time(NULL);
+
+	/* parse commandline returns filename index in argv		*/
+	/* seed, then create floorplan data structure; the		*/
+	/* initial random placement follows the seed too		*/
+	fileNameInd = commandlineParse(argc,argv);
+	setRandSeed(gSeed,0);
+	gfp=fpCreate(argv[fileNameInd]);
 
 	if (gPostScript	) gGUI 		= 1 ;	/* enable gui if post script required		*/
 	if (!gGUI		) gVerbose	= 1 ;	/* enable verbose if if gui is not enabled	*/
 
-	/* change random seed into current time */
-	srandom(time(NULL));
+	if (gVerbose) printf("Random seed: %lu\n",gSeed);
 
 	if (gGUI) {
 
@@ -133,13 +161,22 @@ int main(int argc, char *argv[]) {
 		create_button ((char*)"Run 1000"  , (char*)"Run All"   , runAll   ); /* refresh at end only		*/
 	}
 
+	/* annealing schedule parameters, scaled to the design */
+	movesPerTemp = (unsigned int)MIN(UINT_MAX,MAX(1,gMoveTemp*pow(gfp->cellsN,4.0/3.0)));
+	initTemp	 = (gInitTemp>0) ? gInitTemp*(gfp->bbox) : fpAutoInitTemp(gfp,gfp->cellsN);
+	freezingTemp = gFreezeTemp/(gfp->bbox/gfp->netsN);
+
 	/* invoke simulated-annealing placement with designated parameters */
-	fpAnneal(gfp
-			,(gMoveTemp*(gfp->cellsN)^(4/3))
-			,gInitTemp*(gfp->bbox)
-			,gCoolRate
-			,gFreezeTemp/(gfp->bbox/gfp->netsN)
-	);
+	if		(gParallel==PARALLEL_TEMPERING	)
+		fpTemper			(gfp,gThreads,movesPerTemp,initTemp,gCoolRate,freezingTemp);
+	else if (gParallel==PARALLEL_REGIONS	)
+		fpAnnealRegions		(gfp,gThreads,movesPerTemp,initTemp,gCoolRate,freezingTemp);
+	else if (gParallel==PARALLEL_SPECULATIVE)
+		fpAnnealSpeculative	(gfp,gThreads,movesPerTemp,initTemp,gCoolRate,freezingTemp);
+	else if (gThreads>1						)
+		fpAnnealMultiStart	(gfp,gThreads,movesPerTemp,initTemp,gCoolRate,freezingTemp);
+	else
+		fpAnneal			(gfp		 ,movesPerTemp,initTemp,gCoolRate,freezingTemp);
 
 	/* finished! wait still until 'Exit" is pressed */
 	if (gGUI)
@@ -186,14 +223,85 @@ unsigned int commandlineParse(int argc, char *argv[]	){
 							printf("  -inittemp   (also -i): Initial temperature, followed by a double float\n"	);
 							printf("                         Default is 200, multiplied by initialCost\n"		);
 							printf("                         (same as VPR from utoronto, scaled)\n"						);
+							printf("                         'auto' (or 0) samples random swaps and sets it to\n");
+							printf("                         20 times the cost change std-dev (same as VPR)\n"	);
 							printf("  -freezetemp (also -f): Freezing temperature, followed by a double float\n");
 							printf("                         Default is 5e-6, multiplied by initialCost/net#\n"	);
 							printf("                         (same as VPR from utoronto, scaled)\n"						);
 							printf("  -coolrate   (also -c): Cooling rate, followed by a double float\n"		);
 							printf("                         Default is 0.95 (same as VPR from utoronto)\n"		);
-							printf("  -movetemp   (also -m): Moves per temperature change, followed by an int\n");
-							printf("                         Default is 10, multiplied by (cells#)^(4/3)\n"		);
-							printf("                         (same as VPR from utoronto)\n"						);
+							printf("                         'adaptive' (or 0) sets the rate every temperature\n");
+							printf("                         from the acceptance ratio (same as VPR)\n"			);
+							printf("  -movetemp   (also -m): Moves per temperature change effort, followed by\n");
+							printf("                         a double float or a preset: fast (1), normal (10)\n");
+							printf("                         or high (100); multiplied by (cells#)^(4/3)\n"	);
+							printf("                         Default is normal (same as VPR from utoronto)\n"	);
+							printf("  -limit      (also -l): Range limit, followed by an integer indicating\n"	);
+							printf("                         the max. rows/columns distance of swapped sites\n"	);
+							printf("                         Default is 0, the whole grid\n"					);
+							printf("                         Initial window if the range limiter is enabled\n"	);
+							printf("  -accept     (also -a): Range limiter target acceptance ratio, followed\n"	);
+							printf("                         by a double float; the window shrinks/grows every\n");
+							printf("                         temperature to keep the acceptance near target\n"	);
+							printf("                         Default is 0.44, 0 disables (same as VPR)\n"		);
+							printf("  -bandit     (also -b): Adaptive move types mix; each temperature, favor\n");
+							printf("                         the move types (swap, shift, directed) with the\n"	);
+							printf("                         best recent cost improvement per CPU second.\n"	);
+							printf("                         Overrides -shift and -directed; not supported\n"	);
+							printf("                         with -parallel\n"									);
+							printf("  -directed   (also -d): Final probability of directed moves, followed by\n");
+							printf("                         a double float; a directed move takes a cell into\n");
+							printf("                         the median region of its nets bounding boxes. The\n");
+							printf("                         probability rises from 0 with log(temperature)\n"	);
+							printf("                         Default is 0, disabled\n"							);
+							printf("  -equilibrium(also -e): End a temperature early once the cost mean is\n"	);
+							printf("                         stable between two windows of max(cells#,100)\n"	);
+							printf("                         moves, or nothing is accepted in a window;\n"		);
+							printf("                         moves per temperature is the hard cap; not\n"		);
+							printf("                         supported with -parallel\n"						);
+							printf("  -noimprove  (also -n): Stop when the best cost has not improved for a\n"	);
+							printf("                         number of temperatures, followed by an integer\n"	);
+							printf("                         Default is 0, disabled\n"							);
+							printf("  -parallel  (also -pa): Parallel engine, followed by a mode name:\n"		);
+							printf("                         tempering: replica exchange; replicas anneal at\n"	);
+							printf("                         a ladder of temperatures from the cost change\n"	);
+							printf("                         std-dev (or -inittemp, if lower) to freezing, a\n"	);
+							printf("                         rung every 0.25 of log-temperature, shared among\n");
+							printf("                         -threads (default 4). Per round, the replicas\n"	);
+							printf("                         share moves/temp moves per thread, then neighbour\n");
+							printf("                         rungs exchange placements by a Metropolis test;\n"	);
+							printf("                         the rung spacing adapts to the exchange rates\n"	);
+							printf("                         regions: one cooling chain, moves split among\n"	);
+							printf("                         -threads (default 4) row stripes of at least 4\n"	);
+							printf("                         rows, merged and shifted every temperature\n"		);
+							printf("                         speculative: one cooling chain, -threads (default\n");
+							printf("                         4) evaluate batches of moves in parallel, and a\n"	);
+							printf("                         serial phase commits them, re-proposing moves\n"	);
+							printf("                         that conflict with an earlier commit\n"			);
+							printf("                         Default is none, a single cooling chain\n"			);
+							printf("  -quench     (also -q): Finish with a greedy zero-temperature quench;\n"	);
+							printf("                         only improving swaps in a window of max(final\n"	);
+							printf("                         range limit,3), until a local minimum is reached\n"		);
+							printf("  -seed      (also -se): Random seed, followed by a positive integer; the\n");
+							printf("                         same seed, options, and -threads reproduce the\n"	);
+							printf("                         same placement, unless -timebudget or -bandit\n"	);
+							printf("                         (both driven by measured time) are enabled\n"		);
+							printf("                         Default is the current time\n"						);
+							printf("  -shift      (also -s): Probability of shift moves, followed by a double\n");
+							printf("                         float; a shift relocates a cell into a nearby\n"	);
+							printf("                         empty site, other moves are swaps\n"				);
+							printf("                         Default is 0.1, 0 disables\n"						);
+							printf("  -threads   (also -th): Independent annealers, followed by a positive\n"	);
+							printf("                         integer; each thread anneals a private copy of the\n");
+							printf("                         placement with its own random stream, the best\n"	);
+							printf("                         final placement is kept. Default is 1\n"			);
+							printf("  -timebudget (also -t): Wall-clock time budget in seconds, followed by a\n");
+							printf("                         double float; moves per temperature (and a fixed\n");
+							printf("                         cooling rate) are sized from a short probe of the\n");
+							printf("                         move throughput, then rescaled every temperature\n");
+							printf("                         from the measured throughput to finish in time\n"	);
+							printf("                         (moves per exchange round with -parallel tempering)\n");
+							printf("                         Default is 0, none\n"								);
 							printf("Input file syntax:\n"														);
 							printf("  <CELLS#> <NET#> <ROWS#> <COLUMNS#>\n"										);
 							printf("  <#CELLS_CONNECTED_TO_NET_1> <LIST_OF_CELLS_CONNECTED_TO_NET_1>\n"			);
@@ -216,8 +324,79 @@ unsigned int commandlineParse(int argc, char *argv[]	){
 				case 'g':	gGUI=1;			/* set verbose */
 							break;
 
+				/* adaptive move types mix */
+				case 'b':	gBandit=1;
+							break;
+
+				/* directed moves final probability */
+				case 'd':	argi++;												/* next argument */
+							if (sscanf(argv[argi],"%lf",&gDirectedProb) == 0) {	
+								printf("-E- Commandline error: -directed should be followed by a double float! Exiting...\n");
+								exit(-1);
+							}
+							break;
+
+				/* equilibrium detection */
+				case 'e':	gEquilibrium=1;
+							break;
+
+				/* exit after temperatures without improvement */
+				case 'n':	argi++;												/* next argument */
+							if (sscanf(argv[argi],"%u",&gNoImprove) == 0) {	
+								printf("-E- Commandline error: -noimprove should be followed by a positive integer! Exiting...\n");
+								exit(-1);
+							}
+							break;
+
+				/* greedy quench */
+				case 'q':	gQuench=1;
+							break;
+
+				/* random seed (-se), or shift moves probability */
+				case 's':	if (tolower(argv[argi][2])=='e') {
+								argi++;											/* next argument */
+								if (sscanf(argv[argi],"%lu",&gSeed) == 0) {
+									printf("-E- Commandline error: -seed should be followed by a positive integer! Exiting...\n");
+									exit(-1);
+								}
+								break;
+							}
+							argi++;												/* next argument */
+							if (sscanf(argv[argi],"%lf",&gShiftProb) == 0) {	
+								printf("-E- Commandline error: -shift should be followed by a double float! Exiting...\n");
+								exit(-1);
+							}
+							break;
+
+				/* multi-start threads (-th), or wall-clock time budget */
+				case 't':	if (tolower(argv[argi][2])=='h') {
+								argi++;											/* next argument */
+								if ((sscanf(argv[argi],"%u",&gThreads) == 0) || (gThreads < 1)) {
+									printf("-E- Commandline error: -threads should be followed by a positive integer! Exiting...\n");
+									exit(-1);
+								}
+								break;
+							}
+							argi++;												/* next argument */
+							if (sscanf(argv[argi],"%lf",&gTimeBudget) == 0) {	
+								printf("-E- Commandline error: -timebudget should be followed by a double float! Exiting...\n");
+								exit(-1);
+							}
+							break;
+
 				/* PostScript mode */
-				case 'p':	gPostScript=1;
+				case 'p':	if (tolower(argv[argi][2])=='a') {				/* -parallel	 */
+								argi++;											/* next argument */
+								if (argi<argc && tolower(argv[argi][0])=='t') gParallel=PARALLEL_TEMPERING;
+								else if (argi<argc && tolower(argv[argi][0])=='r') gParallel=PARALLEL_REGIONS;
+								else if (argi<argc && tolower(argv[argi][0])=='s') gParallel=PARALLEL_SPECULATIVE;
+								else {
+									printf("-E- Commandline error: -parallel should be followed by tempering, regions, or speculative! Exiting...\n");
+									exit(-1);
+								}
+								break;
+							}
+							gPostScript=1;
 							break;
 
 				/* refresh rate */
@@ -230,7 +409,8 @@ unsigned int commandlineParse(int argc, char *argv[]	){
 
 				/* initial temperature */
 				case 'i':	argi++;												/* next argument */
-							if (sscanf(argv[argi],"%lf",&gInitTemp) == 0) {	
+							if (tolower(argv[argi][0])=='a') gInitTemp=0;		/* automatic	 */
+							else if (sscanf(argv[argi],"%lf",&gInitTemp) == 0) {	
 								printf("-E- Commandline error: -refreshrate should be followed by a positive integer! Exiting...\n");
 								exit(-1);
 							}
@@ -246,7 +426,8 @@ unsigned int commandlineParse(int argc, char *argv[]	){
 
 				/* cooling rate */
 				case 'c':	argi++;												/* next argument */
-							if (sscanf(argv[argi],"%lf",&gCoolRate) == 0) {	
+							if (tolower(argv[argi][0])=='a') gCoolRate=0;		/* adaptive		 */
+							else if (sscanf(argv[argi],"%lf",&gCoolRate) == 0) {	
 								printf("-E- Commandline error: -refreshrate should be followed by a positive integer! Exiting...\n");
 								exit(-1);
 							}
@@ -254,8 +435,33 @@ unsigned int commandlineParse(int argc, char *argv[]	){
 
 				/* moves per temperature change */
 				case 'm':	argi++;												/* next argument */
-							if (sscanf(argv[argi],"%u",&gMoveTemp) == 0) {	
-								printf("-E- Commandline error: -refreshrate should be followed by a positive integer! Exiting...\n");
+							switch (tolower(argv[argi][0])) {					/* effort preset */
+								case 'f':	gMoveTemp=EFFORT_FAST  ; break;
+								case 'n':	gMoveTemp=EFFORT_NORMAL; break;
+								case 'h':	gMoveTemp=EFFORT_HIGH  ; break;
+								default :	if (sscanf(argv[argi],"%lf",&gMoveTemp) == 0) {
+												printf("-E- Commandline error: -movetemp should be followed by a double float or fast/normal/high! Exiting...\n");
+												exit(-1);
+											}
+							}
+							if (gMoveTemp <= 0) {
+								printf("-E- Commandline error: -movetemp should be positive! Exiting...\n");
+								exit(-1);
+							}
+							break;
+
+				/* range limit */
+				case 'l':	argi++;												/* next argument */
+							if (sscanf(argv[argi],"%u",&gRangeLimit) == 0) {	
+								printf("-E- Commandline error: -limit should be followed by a positive integer! Exiting...\n");
+								exit(-1);
+							}
+							break;
+
+				/* range limiter target acceptance ratio */
+				case 'a':	argi++;												/* next argument */
+							if (sscanf(argv[argi],"%lf",&gAcceptTarget) == 0) {	
+								printf("-E- Commandline error: -accept should be followed by a double float! Exiting...\n");
 								exit(-1);
 							}
 							break;
@@ -270,5 +476,12 @@ unsigned int commandlineParse(int argc, char *argv[]	){
 	/* check if infile is supplied */
 	if (fileNameArgInd<0) {printf(" -E- infile should be supplied\n"); exit(-1);}
 
+	/* parallel engines sweep whole temperatures with a scheduled move types mix */
+	if ((gParallel!=PARALLEL_NONE)&&(gBandit||gEquilibrium)) {
+		printf("-E- Commandline error: -%s is not supported with -parallel! Exiting...\n",
+			   gBandit ? "bandit" : "equilibrium");
+		exit(-1);
+	}
+
 	return fileNameArgInd;
 }
@@ -157,6 +157,30 @@ int arrValueFound(	unsigned int *arr    , unsigned int arrSize  , unsigned int v
 	return 0;
 }
 
+/* returns the k-th smallest value (0-based); partially reorders the array (quickselect) */
+unsigned int arrKth(unsigned int *arr, unsigned int arrSize, unsigned int k) {
+	unsigned int lo=0, hi=arrSize-1;
+	unsigned int i, j, pivot, tmp;
+	while (lo<hi) {
+		pivot = arr[(lo+hi)/2];
+		i=lo; j=hi;
+		while (i<=j) { /* partition around the pivot */
+			while (arr[i]<pivot) i++;
+			while (arr[j]>pivot) j--;
+			if (i<=j) {
+				tmp=arr[i]; arr[i]=arr[j]; arr[j]=tmp;
+				i++;
+				if (j==0) break;
+				j--;
+			}
+		}
+		if		(k<=j) hi=j; /* k-th is in the left part  */
+		else if (k>=i) lo=i; /* k-th is in the right part */
+		else break;			 /* k-th equals the pivot	  */
+	}
+	return arr[k];
+}
+
 /* dump array's values to stdout delimited with 'delimiter' string     */
 void arrDump(unsigned int *arr, unsigned int arrSize, char * delimiter)	{
 	unsigned int i;
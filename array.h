@@ -66,6 +66,9 @@ void		  arrInit(unsigned int *arr, unsigned int initVal, unsigned int arrSize		)
 void		arrRandInit(	unsigned int *arr    , unsigned int  arrSize	,
 							unsigned int  minRand, unsigned int  maxRand				);
 
+/* returns the k-th smallest value (0-based); partially reorders the array				*/
+unsigned int  arrKth(unsigned int *arr, unsigned int arrSize, unsigned int k			);
+
 /* dump array's values to stdout delimited with 'delimiter' string						*/
 void		  arrDump(unsigned int *arr, unsigned int arrSize, char * delimiter			);
 
@@ -41,12 +41,77 @@
 #include <limits.h>
 #include <ctype.h>
 #include <time.h>
+#include <pthread.h>
+#include "geometry.h"
 #include "floorplan.h"
 #include "graphics.h"
 #include "array.h"
 #include "allocation.h"
 #include "random.h"
-#include "geometry.h"
+
+/* equilibrium detection: a temperature ends once the mean cost of two consecutive		*/
+/* windows of moves differs by less than EQ_TOLERANCE standard deviations				*/
+#define EQ_TOLERANCE 0.1
+#define EQ_MIN_WINDOW 100
+
+/* convergence: a temperature counts as not improving if the best cost did not improve	*/
+/* while the current cost stayed within CONVERGE_TOLERANCE of it (the chain is frozen	*/
+/* around the best solution, not still wandering at a high temperature)				*/
+#define CONVERGE_TOLERANCE 0.01
+
+/* greedy quench window radius is at least QUENCH_MIN_RLIM; the range limiter usually	*/
+/* ends at 1, where annealing already found all improving adjacent swaps				*/
+#define QUENCH_MIN_RLIM 3
+
+/* shift moves try SHIFT_TRIES empty sites for a nearby cell before falling back to a	*/
+/* swap; on sparse floorplans most sites near an empty one are empty too				*/
+#define SHIFT_TRIES 8
+
+/* adaptive move types mix (bandit): every BANDIT_SAMPLE moves a block of BANDIT_BLOCK	*/
+/* moves of one type, picked by the mix, is timed as a whole and credited its cost		*/
+/* improvement; a clock read costs nearly as much as a move, so timing single moves		*/
+/* measures the clock. Each type is valued by improvement per second, with the credit	*/
+/* decayed by BANDIT_DECAY every temperature to follow the current temperature.			*/
+/* Every usable type keeps at least BANDIT_MIN_PROB so it can still be measured			*/
+#define BANDIT_SAMPLE 64
+#define BANDIT_BLOCK 16
+#define BANDIT_DECAY 0.5
+#define BANDIT_MIN_PROB 0.05
+
+/* Metropolis acceptance: per temperature, uphill moves with cost increase below		*/
+/* ACCEPT_TABLE_SIZE are accepted by comparing a raw random number against a threshold	*/
+/* table; larger increases fall back to the exact exp() test							*/
+#define ACCEPT_TABLE_SIZE 1024
+
+/* parallel tempering: TEMPER_THREADS threads unless set by -threads; with adaptive		*/
+/* cooling, which gives no temperatures count, replicas exchange TEMPER_ROUNDS times	*/
+#define TEMPER_THREADS 4
+#define TEMPER_ROUNDS 200
+
+/* parallel tempering ladder: a rung every TEMPER_GAP of log-temperature (at most		*/
+/* TEMPER_MAX_RUNGS), so that neighbour rungs overlap; a few rungs spanning decades		*/
+/* never exchange. Every TEMPER_ADAPT rounds, each log-temperature gap is scaled by its	*/
+/* exchange ratio over the mean one (within half to double), then the ladder is			*/
+/* stretched back to its ends: rungs gather where the cost changes fastest				*/
+#define TEMPER_GAP 0.25
+#define TEMPER_MAX_RUNGS 64
+#define TEMPER_ADAPT 20
+
+/* region-partitioned annealing: REGION_THREADS row stripes unless set by -threads,		*/
+/* each at least REGION_MIN_ROWS rows so that the stripe boundaries can shift			*/
+#define REGION_THREADS 4
+#define REGION_MIN_ROWS 4
+
+/* speculative annealing: SPEC_THREADS threads unless set by -threads, each evaluating	*/
+/* up to SPEC_BATCH candidate moves per batch; batches are sized by the last acceptance	*/
+/* ratio to expect SPEC_COMMITS commits, as later candidates conflict with earlier ones	*/
+#define SPEC_THREADS 4
+#define SPEC_BATCH 256
+#define SPEC_COMMITS 8
+
+/* speculative annealing: temperatures after an acceptance ratio above SPEC_MAX_ACCEPT	*/
+/* run serially, since nearly every candidate of a batch would conflict					*/
+#define SPEC_MAX_ACCEPT 0.5
 
 /* global variables																		*/
 double		 gLogCurTemp   ; /* log(temperature), for scale drawing 					*/
@@ -66,8 +131,11 @@ floorplan *fpCreate(const char *fileName												){
 	unsigned int intToken		   ; /* unsigned integer token 							*/
 	unsigned int lineNum=1		   ; /* current parsed line numer 						*/
 	unsigned int neti=0,celli=0	   ; /* net and cell counters 							*/
+	unsigned int pini			   ; /* pin counter										*/
+	unsigned int movei			   ; /* move type counter								*/
+	unsigned int degMax=1		   ; /* max. nets of a cell								*/
 	unsigned int curCell		   ; /* current cell 									*/
-	unsigned int cellx,celly	   ; /* cell palce 										*/
+	unsigned int pinsMax=0		   ; /* allocated size of net->cells CSR indices		*/
 	unsigned int nx,ny	   		   ; /* floorplan size 									*/
 	unsigned int cellsN=0,netsN=0   ; /* number for cells/nets 							*/
 	unsigned int fpSize			   ; /* floorplan area 									*/
@@ -126,15 +194,50 @@ floorplan *fpCreate(const char *fileName												){
 			fp->cellsN		= cellsN;
 			fp->netsN		= netsN;
 			fp->bbox		= 0;
-			fp->cells		= (cell*)safeMalloc(sizeof(cell)*cellsN);
+			fp->pinsN		= 0;
 			fp->cellsOrder	= arrAlloc(fpSize);
+			fp->cellsX		= arrAlloc(fpSize);
+			fp->cellsY		= arrAlloc(fpSize);
+			fp->siteCells	= arrAlloc(fpSize);
 			fp->nets		= (net*)safeMalloc(sizeof(net)*netsN);
-			
-			/* initialize each cell to zero nets */
-			for (celli=0;celli<cellsN;celli++) fp->cells[celli].netsN=0;
+			fp->trialN		= 0;
+			fp->trialDelta	= 0;
+			fp->trialNets	= arrAlloc(netsN);
+			fp->trialBox	= (box*)safeMalloc(sizeof(box)*netsN);
+			fp->netStamp	= arrAlloc(netsN);
+			fp->stamp		= 0;
+			fp->clone		= 0;
+			fp->view		= 0;
+			fp->quiet		= 0;
+			fp->partial		= 0;
+			fp->rowLo		= 0;
+			fp->rowHi		= ny-1;
+			fp->moveCells	= NULL;
+			fp->moveCellsN	= 0;
+			arrInit(fp->netStamp,0,netsN);
+			for(movei=0;movei<MOVE_TYPES;movei++) { /* swaps only by default */
+				fp->moveProb[movei]		= (movei==MOVE_SWAP) ? 1 : 0;
+				fp->moveProposed[movei]	= 0;
+				fp->moveAccepted[movei]	= 0;
+				fp->banditGain[movei]	= 0;
+				fp->banditTime[movei]	= 0;
+			}
+
+			/* CSR netlist; net->cells indices grow while parsing, cell->nets		*/
+			/* offsets count the nets of each cell first							*/
+			pinsMax				= 2*netsN+1;
+			fp->netCellsInd		= arrAlloc(netsN+1);
+			fp->netCells		= arrAlloc(pinsMax);
+			fp->cellNetsInd		= arrAlloc(cellsN+1);
+			fp->cellNets		= NULL; /* size known after parsing */
+			fp->regionX			= NULL;
+			fp->regionY			= NULL;
+			fp->netCellsInd[0]	= 0;
+			arrInit(fp->cellNetsInd,0,cellsN+1);
 
 			/* initialize to random order */
 			arrRandInit(fp->cellsOrder,fpSize,0,fpSize-1);		
+			fpCellsUpdateLoc(fp);
 
 			parseState=NET;
 
@@ -154,14 +257,25 @@ floorplan *fpCreate(const char *fileName												){
 				exit(-1);
 			}
 			
-			/* allocate a net in floorplan nets database */
-			fp->nets[neti].cellsN = buf[0];
-			fp->nets[neti].cells  = arrAlloc(buf[0]);
+			/* append the net cells to the CSR net->cells indices */
+			if ((fp->pinsN)+buf[0] > pinsMax) {
+				pinsMax = 2*((fp->pinsN)+buf[0]);
+				fp->netCells = (unsigned int*)safeRealloc(fp->netCells,sizeof(unsigned int)*pinsMax);
+			}
 			
-			for(celli=0;celli<buf[0];celli++) {
-				fp->nets[neti].cells[celli] = buf[celli+1];
-				(fp->cells[buf[celli+1]].netsN)++;
+			for(celli=1;celli<=buf[0];celli++) {
+				if (buf[celli] >= cellsN) {
+					printf("-E- Parsing error: file %s, line %u: cell %u is out of range! Exiting...\n",fileName,lineNum,buf[celli]);
+					exit(-1);
+				}
+				/* a cell listed twice is one pin; keeps bbox edge counts exact */
+				if (arrValueFound(buf,bufInd+1,buf[celli],1,celli-1)) continue;
+				fp->netCells[fp->pinsN] = buf[celli];
+				(fp->pinsN)++;
+				(fp->cellNetsInd[buf[celli]+1])++; /* count nets of cell */
 			}
+			fp->nets[neti].bbox = 0;
+			fp->netCellsInd[neti+1] = fp->pinsN;
 
 			neti++; /* next net */
 
@@ -179,27 +293,29 @@ floorplan *fpCreate(const char *fileName												){
 	lineNum++; /* next line */
 	} /* while fgets */
 
-	/* cell initialization */
-	cellx=0;celly=0;
-	for(celli=0;celli<cellsN;celli++) {
-
-		/* allocate nets list for each cell */
-		fp->cells[celli].nets = arrAlloc(fp->cells[celli].netsN);
+	/* cell->nets offsets: prefix sum of the nets counts */
+	for(celli=0;celli<cellsN;celli++)
+		fp->cellNetsInd[celli+1] += fp->cellNetsInd[celli];
 
-		/* reset nets numbers for each cell to use as array index */
-		fp->cells[celli].netsN = 0;
-
-	}
-
-	/* upadte nets list for each cell */
+	/* cell->nets indices in one pass over the nets; cellNetsInd is the fill pointer */
+	fp->cellNets = arrAlloc(fp->pinsN);
 	for(neti=0;neti<netsN;neti++){
-		for(celli=0;celli<(fp->nets[neti].cellsN);celli++) {
-			curCell = fp->nets[neti].cells[celli];
-			fp->cells[curCell].nets[fp->cells[curCell].netsN] = neti;
-			(fp->cells[curCell].netsN)++;
-
+		for(pini=fp->netCellsInd[neti];pini<fp->netCellsInd[neti+1];pini++) {
+			curCell = fp->netCells[pini];
+			fp->cellNets[fp->cellNetsInd[curCell]] = neti;
+			(fp->cellNetsInd[curCell])++;
 		}
 	}
+	/* fill pointers now hold the end offsets; shift back to start offsets */
+	for(celli=cellsN;celli>0;celli--)
+		fp->cellNetsInd[celli] = fp->cellNetsInd[celli-1];
+	fp->cellNetsInd[0] = 0;
+
+	/* directed move scratch, two bounds per net of a cell */
+	for(celli=0;celli<cellsN;celli++)
+		degMax = MAX(degMax,fp->cellNetsInd[celli+1]-fp->cellNetsInd[celli]);
+	fp->regionX = arrAlloc(2*degMax);
+	fp->regionY = arrAlloc(2*degMax);
 
 	/* update nets bbox */
 	fpAllNetsUpdateBBox(fp);
@@ -212,28 +328,81 @@ floorplan *fpCreate(const char *fileName												){
 /* free a floorplan data structure	*/
 void fpDelete(floorplan *fp) {
 
-	unsigned int celli,neti; /* indexes */
-
-	/* free net arrays form cells */
-	for(celli=0;celli<(fp->cellsN);celli++) {
-		safeFree(fp->cells[celli].nets);
+	/* free CSR netlist, unless shared with the original floorplan */
+	if (!fp->clone) {
+		safeFree(fp->netCellsInd);
+		safeFree(fp->netCells   );
+		safeFree(fp->cellNetsInd);
+		if (fp->cellNets != NULL) safeFree(fp->cellNets); /* NULL while parsing */
 	}
-	
-	/* free cell arrays from nets */
-	for(neti=0;neti<(fp->netsN);neti++) {
-		safeFree(fp->nets[neti].cells);
+	if (fp->regionX  != NULL) safeFree(fp->regionX );
+	if (fp->regionY  != NULL) safeFree(fp->regionY );
+	if (fp->moveCells!= NULL) safeFree(fp->moveCells);
+
+	/* free placement, unless a view of the original floorplan placement */
+	if (!fp->view) {
+		safeFree(fp->nets );
+		safeFree(fp->cellsX);
+		safeFree(fp->cellsY);
+		safeFree(fp->siteCells);
+		safeFree(fp->cellsOrder);
 	}
-
-	safeFree(fp->cells);
-	safeFree(fp->nets );
+	safeFree(fp->trialNets);
+	safeFree(fp->trialBox );
+	safeFree(fp->netStamp );
+	safeFree(fp);
 
 }	/* fpDelete */
 
+/* returns a new allocated copy of a floorplan with a private placement and scratch,	*/
+/* sharing the read-only netlist of 'fp'; the copy is quiet. Free with fpDelete			*/
+floorplan *fpClone(floorplan *fp) {
+
+	floorplan	*cp		= (floorplan*)safeMalloc(sizeof(floorplan));
+	unsigned int fpSize = (fp->nx)*(fp->ny);
+	unsigned int degMax = 1;	/* max. nets of a cell */
+	unsigned int celli, movei;
+
+	*cp			  = *fp; /* sizes, cost, and the shared CSR netlist */
+	cp->clone	  = 1;
+	cp->view	  = 0;
+	cp->quiet	  = 1;
+	cp->moveCells = NULL;
+	cp->cellsOrder= arrAlloc(fpSize);
+	cp->cellsX	  = arrAlloc(fpSize);
+	cp->cellsY	  = arrAlloc(fpSize);
+	cp->siteCells = arrAlloc(fpSize);
+	cp->nets	  = (net*)safeMalloc(sizeof(net)*(fp->netsN));
+	cp->trialN	  = 0;
+	cp->trialNets = arrAlloc(fp->netsN);
+	cp->trialBox  = (box*)safeMalloc(sizeof(box)*(fp->netsN));
+	cp->netStamp  = arrAlloc(fp->netsN);
+	cp->stamp	  = 0;
+	arrInit(cp->netStamp,0,fp->netsN);
+	arrCopy(fp->cellsOrder,cp->cellsOrder,fpSize);
+	arrCopy(fp->cellsX	  ,cp->cellsX	 ,fpSize);
+	arrCopy(fp->cellsY	  ,cp->cellsY	 ,fpSize);
+	arrCopy(fp->siteCells ,cp->siteCells ,fpSize);
+	memcpy(cp->nets,fp->nets,sizeof(net)*(fp->netsN));
+	for(celli=0;celli<fp->cellsN;celli++)
+		degMax = MAX(degMax,fp->cellNetsInd[celli+1]-fp->cellNetsInd[celli]);
+	cp->regionX	  = arrAlloc(2*degMax);
+	cp->regionY	  = arrAlloc(2*degMax);
+	for(movei=0;movei<MOVE_TYPES;movei++) {
+		cp->moveProposed[movei]	= 0;
+		cp->moveAccepted[movei]	= 0;
+		cp->banditGain[movei]	= 0;
+		cp->banditTime[movei]	= 0;
+	}
+
+	return cp;
+
+}	/* fpClone */
+
 /* dump a floorplan data structure to stdout - for verification purpose	*/
 void fpDump (floorplan  *fp) {
 
 	unsigned int neti,celli	; /* indexes 		*/
-	point 		 cellLoc	; /* cell location 	*/
 
 	/* print floorplan details */
 	printf("Floorplan:\n");
@@ -245,43 +414,101 @@ void fpDump (floorplan  *fp) {
 	/* list nets */
 	printf("Nets:\n");
 	for(neti=0;neti<(fp->netsN);neti++) {
-		printf("\tNet#%u: bbox: %u, cells #: %u, cells:",neti,fp->nets[neti].bbox,fp->nets[neti].cellsN);
-		arrDump(fp->nets[neti].cells,fp->nets[neti].cellsN," ");
+		printf("\tNet#%u: bbox: %u, cells #: %u, cells:",neti,fp->nets[neti].bbox,
+				fp->netCellsInd[neti+1]-fp->netCellsInd[neti]			);
+		arrDump(fp->netCells+fp->netCellsInd[neti],fp->netCellsInd[neti+1]-fp->netCellsInd[neti]," ");
 		printf("\n");
 	}
 
 	/* list cells */
 	printf("Cells:\n");
 	for(celli=0;celli<(fp->cellsN);celli++) {
-		cellLoc = index1Dto2D(fp->cellsOrder[celli],fp->nx,fp->ny);
 		printf("\tCell#%u: location (%u,%u), nets #: %u, nets:",
-				celli, cellLoc.x, cellLoc.y,
-				fp->cells[celli].netsN							);
-		arrDump(fp->cells[celli].nets,fp->cells[celli].netsN," ");
+				celli, fp->cellsX[celli], fp->cellsY[celli],
+				fp->cellNetsInd[celli+1]-fp->cellNetsInd[celli]	);
+		arrDump(fp->cellNets+fp->cellNetsInd[celli],fp->cellNetsInd[celli+1]-fp->cellNetsInd[celli]," ");
 		printf("\n");
 	}
 
 }	/* fpDump */
 
+/* bbox cost (1/2 perimeter) of a net bounding box										*/
+static unsigned int fpBoxCost(box *bbox) {
+	return (bbox->xmax-bbox->xmin) + 2*(bbox->ymax-bbox->ymin); /* double row */
+} /* fpBoxCost */
+
+/* add a point to a bounding box, counting the points on each edge						*/
+static void fpBoxAddPoint(box *bbox, unsigned int x, unsigned int y) {
+	if		(x <  bbox->xmin) {bbox->xmin=x; bbox->xminN=1;}
+	else if (x == bbox->xmin) (bbox->xminN)++;
+	if		(x >  bbox->xmax) {bbox->xmax=x; bbox->xmaxN=1;}
+	else if (x == bbox->xmax) (bbox->xmaxN)++;
+	if		(y <  bbox->ymin) {bbox->ymin=y; bbox->yminN=1;}
+	else if (y == bbox->ymin) (bbox->yminN)++;
+	if		(y >  bbox->ymax) {bbox->ymax=y; bbox->ymaxN=1;}
+	else if (y == bbox->ymax) (bbox->ymaxN)++;
+} /* fpBoxAddPoint */
+
+/* bounding box of a two-pin net, straight min/max arithmetic							*/
+static void fpBox2Pins(box *bbox, unsigned int x0, unsigned int y0,
+								  unsigned int x1, unsigned int y1) {
+	bbox->xmin  = MIN(x0,x1); bbox->xmax  = MAX(x0,x1);
+	bbox->ymin  = MIN(y0,y1); bbox->ymax  = MAX(y0,y1);
+	bbox->xminN = bbox->xmaxN = (x0==x1) ? 2 : 1;
+	bbox->yminN = bbox->ymaxN = (y0==y1) ? 2 : 1;
+} /* fpBox2Pins */
+
+/* bounding box of a net in one pass, from the cells x/y coordinates (no allocation)	*/
+/* pins of cellA are taken at the place of cellB and vice versa (trial swap)			*/
+static void fpNetBounds(floorplan *fp, unsigned int netID,
+						unsigned int cellA, unsigned int cellB, box *bbox				) {
+
+	unsigned int  firstPin = fp->netCellsInd[netID  ];
+	unsigned int  lastPin  = fp->netCellsInd[netID+1];
+	unsigned int  curCell, pini, x, y;
+
+	for(pini=firstPin; pini<lastPin; pini++) {
+		curCell = fp->netCells[pini];
+		if		(curCell == cellA) curCell = cellB;
+		else if (curCell == cellB) curCell = cellA;
+		x = fp->cellsX[curCell];
+		y = fp->cellsY[curCell];
+		if (pini == firstPin) {
+			bbox->xmin  = bbox->xmax  = x;
+			bbox->ymin  = bbox->ymax  = y;
+			bbox->xminN = bbox->xmaxN = 1;
+			bbox->yminN = bbox->ymaxN = 1;
+			continue;
+		}
+		fpBoxAddPoint(bbox,x,y);
+	}
+
+} /* fpNetBounds */
+
+/* update cells x/y coordinates and the site->cell map from the cells order			*/
+/* (after changing cellsOrder)															*/
+void fpCellsUpdateLoc(floorplan *fp) {
+
+	unsigned int celli;
+
+	for(celli=0;celli<(fp->nx)*(fp->ny);celli++) {
+		fp->cellsX[celli] = fp->cellsOrder[celli]%(fp->nx);
+		fp->cellsY[celli] = fp->cellsOrder[celli]/(fp->nx);
+		fp->siteCells[fp->cellsOrder[celli]] = celli;
+	}
+
+} /* fpCellsUpdateLoc */
+
 /* update net's bbox in the floorplan database											*/
 unsigned int fpNetUpdateBBox(floorplan *fp, unsigned int netID) {
 
-	net  curNet = fp->nets[netID];
-	point *netPoints = (point*)safeMalloc(sizeof(cell)*curNet.cellsN);
-	point cellLoc;
-	unsigned int curCell, celli, bbox, bboxOld;
+	unsigned int bbox, bboxOld;
 
-	for(celli=0; celli<curNet.cellsN; celli++) {
-		curCell = curNet.cells[celli];
-		cellLoc = index1Dto2D(fp->cellsOrder[curCell],fp->nx,fp->ny);
-		netPoints[celli].x =   cellLoc.x;
-		netPoints[celli].y = 2*cellLoc.y; /* double row */
-	}
-	bbox = pointsBBoxHalfPerimeter(netPoints,curNet.cellsN);
+	fpNetBounds(fp,netID,UINT_MAX,UINT_MAX,&(fp->nets[netID].bounds)); /* no trial */
+	bbox = fpBoxCost(&(fp->nets[netID].bounds));
 	bboxOld = fp->nets[netID].bbox;
 	fp->nets[netID].bbox = bbox;
 	fp->bbox += (bbox-bboxOld);
-	safeFree(netPoints);
 
 	return bbox;
 
@@ -290,10 +517,10 @@ unsigned int fpNetUpdateBBox(floorplan *fp, unsigned int netID) {
 /* update the bbox of all nets connected to this cell in the floorplan database			*/
 void fpCellUpdateBBox(floorplan *fp, unsigned int cellId) {
 
-	unsigned int neti;
+	unsigned int pini;
 
-	for(neti=0; neti<(fp->cells[cellId].netsN); neti++) {
-		fpNetUpdateBBox(fp, fp->cells[cellId].nets[neti]);
+	for(pini=fp->cellNetsInd[cellId]; pini<fp->cellNetsInd[cellId+1]; pini++) {
+		fpNetUpdateBBox(fp, fp->cellNets[pini]);
 	}
 
 } /* fpCellUpdateBBox */
@@ -313,13 +540,11 @@ void fpAllNetsUpdateBBox(floorplan *fp)  {
 void fpDrawGrid(floorplan *fp, float x0, float y0, float x1, float y1					){
 
 	unsigned int ny=fp->ny, nx=fp->nx				; /* dimention        				*/
-	unsigned int celli,neti							; /* cell/net counters 				*/
+	unsigned int celli,neti,pini					; /* cell/net/pin counters 			*/
 	float		 dx=x1-x0, dy=y1-y0					; /* grid dimention 				*/
 	float		 step=MIN((dy/(ny*2)),(dx/(nx+1)))	; /* one grid step					*/
 	char		 label[16]							; /* general label  				*/
-	net			 curNet								; /* current net 					*/
 	unsigned int curCell, srcCell					; /* current/source cell number 	*/
-	point		 cellLoc							; /* cell location 					*/
 	unsigned int srcx,srcy,curx,cury				; /* drawing location 				*/
 
 	/* draw grid background */
@@ -328,33 +553,31 @@ void fpDrawGrid(floorplan *fp, float x0, float y0, float x1, float y1					){
 
 	/* draw cells on grid*/
 	for(celli=0;celli<(nx*ny);celli++) {
-		cellLoc = index1Dto2D(fp->cellsOrder[celli],fp->nx,fp->ny);
+		curx = fp->cellsX[celli];
+		cury = fp->cellsY[celli];
 		if (celli<(fp->cellsN)) setcolor(BLUE ); /* if cell, paint with blue  */
 						   else setcolor(WHITE); /* if void, paint with white */
-		fillrect((cellLoc.x+.5)*step+x0,(cellLoc.y*2+.5)*step+y0,(cellLoc.x+1.5)*step+x0,(cellLoc.y*2+1.5)*step+y0);
+		fillrect((curx+.5)*step+x0,(cury*2+.5)*step+y0,(curx+1.5)*step+x0,(cury*2+1.5)*step+y0);
 		setcolor(BLACK);
-		drawrect((cellLoc.x+.5)*step+x0,(cellLoc.y*2+.5)*step+y0,(cellLoc.x+1.5)*step+x0,(cellLoc.y*2+1.5)*step+y0);
+		drawrect((curx+.5)*step+x0,(cury*2+.5)*step+y0,(curx+1.5)*step+x0,(cury*2+1.5)*step+y0);
 		if (celli<(fp->cellsN)) { /* if cell, make label */
 			setcolor(WHITE);
 			sprintf(label,"%u",celli);
-			drawtext((cellLoc.x+1)*step+x0,(cellLoc.y*2+0.75)*step+y0,label,step);
+			drawtext((curx+1)*step+x0,(cury*2+0.75)*step+y0,label,step);
 		}
 	}
 
 	/* draw wires */
 	setcolor(RED);
 	for(neti=0;neti<(fp->netsN);neti++) {
-		curNet = fp->nets[neti];
-		srcCell = curNet.cells[0];
-		cellLoc = index1Dto2D(fp->cellsOrder[srcCell],fp->nx,fp->ny);
-		srcx = cellLoc.x;
-		srcy = cellLoc.y;
+		srcCell = fp->netCells[fp->netCellsInd[neti]];
+		srcx = fp->cellsX[srcCell];
+		srcy = fp->cellsY[srcCell];
 		fillarc ((srcx+1)*step+x0,(srcy*2+1)*step+y0,step/10,0.,360.);
-		for(celli=1;celli<curNet.cellsN;celli++) {
-			curCell = curNet.cells[celli];
-			cellLoc = index1Dto2D(fp->cellsOrder[curCell],fp->nx,fp->ny);
-			curx = cellLoc.x;
-			cury = cellLoc.y;
+		for(pini=fp->netCellsInd[neti]+1;pini<fp->netCellsInd[neti+1];pini++) {
+			curCell = fp->netCells[pini];
+			curx = fp->cellsX[curCell];
+			cury = fp->cellsY[curCell];
 			fillarc ((curx+1)*step+x0,(cury*2+1)*step+y0,step/10,0.,360.);
 			drawline((srcx+1)*step+x0,(srcy*2+1)*step+y0,(curx+1)*step+x0,(cury*2+1)*step+y0);		
 		}
@@ -433,107 +656,1952 @@ void fpDraw(floorplan *fp, float xWorld, float yWorld) {
 
 } /* fpDraw */
 
-/* swap the order of two cells and update the cost										*/
-void		 fpSwapCells(floorplan *fp, unsigned int cellId1, unsigned int cellId2) 	{
+/* evaluate the trial bbox of all nets of a cell moving from 'from' to 'to'				*/
+/* nets stamped with 'sharedStamp' are shared by both swapped cells; their pins just	*/
+/* exchange places so the bbox is unchanged. They are stamped with stamp+1 and skipped	*/
+/* other nets do not hold the other swapped cell, so their other pins stay in place:	*/
+/* two- and three-pin nets are computed directly from the pins, larger nets are			*/
+/* updated incrementally																*/
+static void fpCellTrialMove(floorplan *fp, unsigned int cellId, point from, point to,
+							unsigned int sharedStamp									) {
+
+	unsigned int pini, curNet, firstPin, other1, other2;
+	box			 bbox;
+
+	for(pini=fp->cellNetsInd[cellId]; pini<fp->cellNetsInd[cellId+1]; pini++) {
+		curNet = fp->cellNets[pini];
+		if (fp->netStamp[curNet] == sharedStamp) { /* shared net */
+			fp->netStamp[curNet] = fp->stamp+1;
+			continue;
+		}
+		firstPin = fp->netCellsInd[curNet];
+		switch (fp->netCellsInd[curNet+1]-firstPin) { /* net fanout */
+		  case 2:
+			other1 = fp->netCells[firstPin + (fp->netCells[firstPin]==cellId)];
+			fpBox2Pins(&bbox,to.x,to.y,fp->cellsX[other1],fp->cellsY[other1]);
+			break;
+		  case 3:
+			if		(fp->netCells[firstPin  ]==cellId) {other1=fp->netCells[firstPin+1]; other2=fp->netCells[firstPin+2];}
+			else if (fp->netCells[firstPin+1]==cellId) {other1=fp->netCells[firstPin  ]; other2=fp->netCells[firstPin+2];}
+			else									   {other1=fp->netCells[firstPin  ]; other2=fp->netCells[firstPin+1];}
+			fpBox2Pins(&bbox,to.x,to.y,fp->cellsX[other1],fp->cellsY[other1]);
+			fpBoxAddPoint(&bbox,fp->cellsX[other2],fp->cellsY[other2]);
+			break;
+		  default: /* incremental update; full rescan only if the pin was alone on an edge */
+			bbox = fp->nets[curNet].bounds;
+			if (!boxMovePoint(&bbox,from,to)) fpNetBounds(fp,curNet,fp->trialCell1,fp->trialCell2,&bbox);
+		}
+		fp->trialNets[fp->trialN] = curNet;
+		fp->trialBox [fp->trialN] = bbox;
+		fp->trialDelta += (int)fpBoxCost(&bbox) - (int)(fp->nets[curNet].bbox);
+		(fp->trialN)++;
+	}
 
-	unsigned int tmp;
+} /* fpCellTrialMove */
+
+/* evaluate the cost change (new-old) of relocating a cell into an empty site (void);	*/
+/* only the moving cell nets are evaluated. Commit with fpCommitSwap					*/
+int			 fpEvaluateShift(floorplan *fp, unsigned int cellId, unsigned int voidId)	{
+
+	point		 from, to;
+
+	fp->trialCell1 = cellId;
+	fp->trialCell2 = voidId;
+	fp->trialDelta = 0;
+	fp->trialN     = 0;
+	if (cellId>=(fp->cellsN)) return 0; /* two voids, nothing moves */
+
+	from.x = fp->cellsX[cellId]; from.y = fp->cellsY[cellId];
+	to.x   = fp->cellsX[voidId]; to.y   = fp->cellsY[voidId];
+
+	/* no shared nets; stamps are >=2, so stamp 1 never matches */
+	fpCellTrialMove(fp,cellId,from,to,1);
+
+	return fp->trialDelta;
+
+} /* fpEvaluateShift */
+
+/* evaluate the cost change (new-old) of swapping two cells, floorplan is untouched	*/
+/* the trial result is kept in the floorplan scratch area for fpCommitSwap			*/
+int			 fpEvaluateSwap(floorplan *fp, unsigned int cellId1, unsigned int cellId2)	{
+
+	unsigned int pini;
+	point		 loc1, loc2;
+
+	/* a void (id>=cellsN) has no nets, swapping with it is a shift */
+	if (cellId1>=(fp->cellsN)) return fpEvaluateShift(fp,cellId2,cellId1);
+	if (cellId2>=(fp->cellsN)) return fpEvaluateShift(fp,cellId1,cellId2);
+
+	/* new stamp pair (stamp,stamp+1); on wrap around reset all nets stamps */
+	fp->stamp += 2;
+	if (fp->stamp == 0) {
+		arrInit(fp->netStamp,0,fp->netsN);
+		fp->stamp = 2;
+	}
+
+	fp->trialCell1 = cellId1;
+	fp->trialCell2 = cellId2;
+	fp->trialDelta = 0;
+	fp->trialN     = 0;
+
+	loc1.x = fp->cellsX[cellId1]; loc1.y = fp->cellsY[cellId1];
+	loc2.x = fp->cellsX[cellId2]; loc2.y = fp->cellsY[cellId2];
+
+	/* mark second cell nets */
+	for(pini=fp->cellNetsInd[cellId2]; pini<fp->cellNetsInd[cellId2+1]; pini++)
+		fp->netStamp[fp->cellNets[pini]] = fp->stamp;
+	fpCellTrialMove(fp,cellId1,loc1,loc2,fp->stamp  );
+	fpCellTrialMove(fp,cellId2,loc2,loc1,fp->stamp+1);
+
+	return fp->trialDelta;
+
+} /* fpEvaluateSwap */
+
+/* apply the last swap evaluated by fpEvaluateSwap and update the cost					*/
+void		 fpCommitSwap(floorplan *fp)												{
+
+	unsigned int tmp, triali, curNet;
 
 	/* swap */
-	tmp = fp->cellsOrder[cellId1];
-	fp->cellsOrder[cellId1] = fp->cellsOrder[cellId2];
-	fp->cellsOrder[cellId2] = tmp;
+	tmp = fp->cellsOrder[fp->trialCell1];
+	fp->cellsOrder[fp->trialCell1] = fp->cellsOrder[fp->trialCell2];
+	fp->cellsOrder[fp->trialCell2] = tmp;
+	tmp = fp->cellsX[fp->trialCell1];
+	fp->cellsX[fp->trialCell1] = fp->cellsX[fp->trialCell2];
+	fp->cellsX[fp->trialCell2] = tmp;
+	tmp = fp->cellsY[fp->trialCell1];
+	fp->cellsY[fp->trialCell1] = fp->cellsY[fp->trialCell2];
+	fp->cellsY[fp->trialCell2] = tmp;
+	fp->siteCells[fp->cellsOrder[fp->trialCell1]] = fp->trialCell1;
+	fp->siteCells[fp->cellsOrder[fp->trialCell2]] = fp->trialCell2;
+
+	/* write back the trial bounding box of the touched nets */
+	for(triali=0; triali<(fp->trialN); triali++) {
+		curNet = fp->trialNets[triali];
+		fp->nets[curNet].bounds = fp->trialBox[triali];
+		fp->nets[curNet].bbox   = fpBoxCost(&(fp->trialBox[triali]));
+	}
+	fp->bbox += fp->trialDelta;
 
-	/* update cost */
-	if (cellId1<(fp->cellsN)) fpCellUpdateBBox(fp,cellId1);
-	if (cellId2<(fp->cellsN)) fpCellUpdateBBox(fp,cellId2);
+} /* fpCommitSwap */
+
+/* swap the order of two cells and update the cost										*/
+void		 fpSwapCells(floorplan *fp, unsigned int cellId1, unsigned int cellId2) 	{
+
+	fpEvaluateSwap(fp,cellId1,cellId2);
+	fpCommitSwap(fp);
 
 } /* fpSwapCells */
 
-/* simulated annealing placement 											*/
-void fpAnneal(floorplan *fp, unsigned int movesPerTemp, double initTemp		,
-							 double coolingRate	      , double freezingTemp	){
+/* first cell of a move: a random cell, or one of moveCells if the moves are limited	*/
+/* to the rows region [rowLo,rowHi]														*/
+static unsigned int fpFirstCell(floorplan *fp) {
+
+	if (fp->moveCells != NULL)
+		return fp->moveCells[getUIntRand(0,fp->moveCellsN-1)];
+	return getUIntRand(0,MAX(fp->cellsN,1)-1);
+
+} /* fpFirstCell */
+
+/* pick a random cell and a second one (or void) whose site is within 'rlim'			*/
+/* columns and rows from the first, inside the floorplan and the rows region. The		*/
+/* first is never a void, so no move is wasted swapping two empty sites					*/
+void		 fpRangeLimitedMove(floorplan *fp, unsigned int rlim,
+								unsigned int *cellId1, unsigned int *cellId2			){
+
+	unsigned int x1, y1, x2, y2;
+	unsigned int xmin, xmax, ymin, ymax;
+
+	if (rlim < 1) rlim = 1; /* at least the adjacent sites */
+
+	*cellId1 = fpFirstCell(fp);
+	x1 = fp->cellsX[*cellId1];
+	y1 = fp->cellsY[*cellId1];
+
+	/* window around the first site */
+	xmin = (x1>rlim) ? x1-rlim : 0;
+	ymin = MAX((y1>rlim) ? y1-rlim : 0,fp->rowLo);
+	xmax = MIN(x1+rlim,(fp->nx)-1);
+	ymax = MIN(y1+rlim,fp->rowHi);
+
+	do { /* until a different site */
+		x2 = getUIntRand(xmin,xmax);
+		y2 = getUIntRand(ymin,ymax);
+	} while ((x2==x1)&&(y2==y1));
+
+	*cellId2 = fp->siteCells[y2*(fp->nx)+x2];
+
+} /* fpRangeLimitedMove */
+
+/* swap move generator, returns the move type										*/
+static unsigned int fpSwapMove(floorplan *fp, unsigned int rlim,
+							   unsigned int *cellId1, unsigned int *cellId2				) {
+
+	fpRangeLimitedMove(fp,rlim,cellId1,cellId2);
+	return MOVE_SWAP;
+
+} /* fpSwapMove */
+
+/* shift move generator: the voids (ids cellsN..nx*ny-1) are the free-site list, their	*/
+/* cellsOrder entries are the empty sites and are kept by every committed swap. Pick	*/
+/* an empty site in O(1), then a cell within 'rlim' of it to relocate there. Falls back	*/
+/* to a swap if there are no voids or no cell is found near SHIFT_TRIES empty sites		*/
+static unsigned int fpShiftMove(floorplan *fp, unsigned int rlim,
+								unsigned int *cellId1, unsigned int *cellId2			) {
 
-	unsigned int cellId1,cellId2;
-	unsigned int imove;
 	unsigned int maxInd = (fp->nx)*(fp->ny)-1;
-	unsigned int oldCost, newCost;
-	int gain;
-	unsigned int stepsCnt = 0;
-	unsigned int *bestOrder = arrAlloc(maxInd+1);
-	unsigned int  bestCost  = fp->bbox;
+	unsigned int x1, y1, x2, y2;
+	unsigned int xmin, xmax, ymin, ymax;
+	unsigned int tryi;
+
+	if (rlim < 1) rlim = 1;
+
+	for(tryi=0; (tryi<SHIFT_TRIES)&&(fp->cellsN<=maxInd); tryi++) {
+		*cellId2 = getUIntRand(fp->cellsN,maxInd); /* an empty site */
+		x2 = fp->cellsX[*cellId2];
+		y2 = fp->cellsY[*cellId2];
+		if ((y2<fp->rowLo)||(y2>fp->rowHi)) continue; /* out of the rows region */
+
+		/* window around the empty site */
+		xmin = (x2>rlim) ? x2-rlim : 0;
+		ymin = MAX((y2>rlim) ? y2-rlim : 0,fp->rowLo);
+		xmax = MIN(x2+rlim,(fp->nx)-1);
+		ymax = MIN(y2+rlim,fp->rowHi);
+
+		do { /* until a different site */
+			x1 = getUIntRand(xmin,xmax);
+			y1 = getUIntRand(ymin,ymax);
+		} while ((x1==x2)&&(y1==y2));
+
+		*cellId1 = fp->siteCells[y1*(fp->nx)+x1];
+		if (*cellId1 < fp->cellsN) return MOVE_SHIFT; /* a cell, not another void */
+	}
+
+	return fpSwapMove(fp,rlim,cellId1,cellId2);
+
+} /* fpShiftMove */
+
+/* clip the range [*lo,*hi] into the window [wlo,whi]; if they are disjoint, collapse	*/
+/* it to the window end nearest to the range											*/
+static void fpClipRange(unsigned int *lo, unsigned int *hi, unsigned int wlo, unsigned int whi) {
+
+	if		(*lo > whi) *lo = *hi = whi;
+	else if (*hi < wlo) *lo = *hi = wlo;
+	else {
+		*lo = MAX(*lo,wlo);
+		*hi = MIN(*hi,whi);
+	}
+
+} /* fpClipRange */
+
+/* directed move generator: the optimal region of a cell is the median of the bounding	*/
+/* boxes of its nets, the cell itself excluded. Pick a target site in that region,		*/
+/* clipped to 'rlim' rows/columns from the cell, and swap with its cell or void. Falls	*/
+/* back to a swap if the cell has no other connected cells or sits alone in its region	*/
+static unsigned int fpDirectedMove(floorplan *fp, unsigned int rlim,
+								   unsigned int *cellId1, unsigned int *cellId2			) {
+
+	unsigned int pini, pinj, curNet, curCell;
+	unsigned int x1, y1, x2, y2, x, y;
+	unsigned int xmin, xmax, ymin, ymax;
+	unsigned int boundsN = 0;
+	box			 bounds;
+
+	if (rlim < 1) rlim = 1;
+
+	*cellId1 = fpFirstCell(fp);
+	x1 = fp->cellsX[*cellId1];
+	y1 = fp->cellsY[*cellId1];
+
+	for(pini=fp->cellNetsInd[*cellId1]; pini<fp->cellNetsInd[*cellId1+1]; pini++) {
+		curNet = fp->cellNets[pini];
+		if (fp->netCellsInd[curNet+1]-fp->netCellsInd[curNet] < 2) continue; /* cell only */
+
+		/* net bounds hold without the cell, unless it is alone on an edge */
+		bounds = fp->nets[curNet].bounds;
+		if (((x1==bounds.xmin)&&(bounds.xminN==1))||((x1==bounds.xmax)&&(bounds.xmaxN==1))||
+			((y1==bounds.ymin)&&(bounds.yminN==1))||((y1==bounds.ymax)&&(bounds.ymaxN==1))) {
+			bounds.xmin = bounds.ymin = UINT_MAX;
+			bounds.xmax = bounds.ymax = 0;
+			for(pinj=fp->netCellsInd[curNet]; pinj<fp->netCellsInd[curNet+1]; pinj++) {
+				curCell = fp->netCells[pinj];
+				if (curCell == *cellId1) continue;
+				x = fp->cellsX[curCell];
+				y = fp->cellsY[curCell];
+				bounds.xmin = MIN(bounds.xmin,x); bounds.xmax = MAX(bounds.xmax,x);
+				bounds.ymin = MIN(bounds.ymin,y); bounds.ymax = MAX(bounds.ymax,y);
+			}
+		}
+		fp->regionX[boundsN  ] = bounds.xmin; fp->regionX[boundsN+1] = bounds.xmax;
+		fp->regionY[boundsN  ] = bounds.ymin; fp->regionY[boundsN+1] = bounds.ymax;
+		boundsN += 2;
+	}
+	if (boundsN == 0) return fpSwapMove(fp,rlim,cellId1,cellId2); /* unconnected */
+
+	/* median region, between the two middle bounds */
+	xmin = arrKth(fp->regionX,boundsN,boundsN/2-1);
+	xmax = arrKth(fp->regionX,boundsN,boundsN/2  );
+	ymin = arrKth(fp->regionY,boundsN,boundsN/2-1);
+	ymax = arrKth(fp->regionY,boundsN,boundsN/2  );
+
+	/* clip to the window around the cell */
+	fpClipRange(&xmin,&xmax,(x1>rlim) ? x1-rlim : 0,MIN(x1+rlim,(fp->nx)-1));
+	fpClipRange(&ymin,&ymax,MAX((y1>rlim) ? y1-rlim : 0,fp->rowLo),MIN(y1+rlim,fp->rowHi));
+	if ((xmin==xmax)&&(ymin==ymax)&&(xmin==x1)&&(ymin==y1))
+		return fpSwapMove(fp,rlim,cellId1,cellId2); /* already in place */
+
+	do { /* until a different site */
+		x2 = getUIntRand(xmin,xmax);
+		y2 = getUIntRand(ymin,ymax);
+	} while ((x2==x1)&&(y2==y1));
+
+	*cellId2 = fp->siteCells[y2*(fp->nx)+x2];
+	return MOVE_DIRECTED;
+
+} /* fpDirectedMove */
+
+/* move generators by move type, and their names for reports							*/
+typedef unsigned int (*fpMoveGen)(floorplan *fp, unsigned int rlim,
+								  unsigned int *cellId1, unsigned int *cellId2);
+static const fpMoveGen	fpMoveGens [MOVE_TYPES] = {fpSwapMove, fpShiftMove, fpDirectedMove};
+static const char	   *fpMoveNames[MOVE_TYPES] = {"Swap"	 , "Shift"	  , "Directed"	  };
+
+/* move types mix: directed moves with 'directedProb', the rest split between shifts	*/
+/* (gShiftProb, none if the floorplan is full) and swaps								*/
+static void fpMoveMix(floorplan *fp, double directedProb) {
+
+	double shiftProb = (fp->cellsN<(fp->nx)*(fp->ny)) ? MIN(MAX(gShiftProb,0),1) : 0;
+
+	directedProb				= MIN(MAX(directedProb,0),1);
+	fp->moveProb[MOVE_DIRECTED]	= directedProb;
+	fp->moveProb[MOVE_SHIFT   ]	= (1-directedProb)*shiftProb;
+	fp->moveProb[MOVE_SWAP    ]	= (1-directedProb)*(1-shiftProb);
+
+} /* fpMoveMix */
+
+/* adaptive move types mix (bandit): each usable type gets a probability by its			*/
+/* decayed improvement per second, above a BANDIT_MIN_PROB floor; then decay credit		*/
+static void fpBanditMix(floorplan *fp) {
+
+	unsigned int moveType, typesN = 0;
+	int			 usable[MOVE_TYPES];
+	double		 value [MOVE_TYPES];
+	double		 valueSum = 0;
+
+	for(moveType=0;moveType<MOVE_TYPES;moveType++) {
+		usable[moveType] = (moveType!=MOVE_SHIFT)||(fp->cellsN<(fp->nx)*(fp->ny));
+		value [moveType] = (fp->banditTime[moveType]>0) ? fp->banditGain[moveType]/fp->banditTime[moveType] : 0;
+		if (usable[moveType]) {
+			typesN++;
+			valueSum += value[moveType];
+		}
+	}
+
+	for(moveType=0;moveType<MOVE_TYPES;moveType++) {
+		if (!usable[moveType])	fp->moveProb[moveType] = 0;
+		else if (valueSum<=0)	fp->moveProb[moveType] = 1.0/typesN; /* nothing learned yet */
+		else					fp->moveProb[moveType] = BANDIT_MIN_PROB +
+											(1-typesN*BANDIT_MIN_PROB)*value[moveType]/valueSum;
+		fp->banditGain[moveType] *= BANDIT_DECAY;
+		fp->banditTime[moveType] *= BANDIT_DECAY;
+	}
+
+} /* fpBanditMix */
+
+/* pick a move type by fp->moveProb (roulette)											*/
+unsigned int fpPickMoveType(floorplan *fp){
+
+	unsigned int moveType = 0;
+	double		 r		  = (MOVE_TYPES>1) ? getFloatRand(0,1) : 0;
+
+	while ((moveType<MOVE_TYPES-1)&&(r>=fp->moveProb[moveType]))
+		r -= fp->moveProb[moveType++];
+	return moveType;
+
+} /* fpPickMoveType */
+
+/* propose a move of the given type; the generator may fall back to another type		*/
+/* (a shift with no empty site nearby is a swap). Returns the type, counted as proposed	*/
+unsigned int fpProposeMoveOf(floorplan *fp, unsigned int moveType, unsigned int rlim,
+							 unsigned int *cellId1, unsigned int *cellId2				){
+
+	moveType = fpMoveGens[moveType](fp,rlim,cellId1,cellId2);
+	fp->moveProposed[moveType]++;
+	return moveType;
+
+} /* fpProposeMoveOf */
+
+/* move generator: pick a move type by fp->moveProb and propose a move of that type;	*/
+/* the first cell is never a void. Returns the move type, counted as proposed			*/
+unsigned int fpProposeMove(floorplan *fp, unsigned int rlim,
+						   unsigned int *cellId1, unsigned int *cellId2				){
+
+	return fpProposeMoveOf(fp,fpPickMoveType(fp),rlim,cellId1,cellId2);
+
+} /* fpProposeMove */
+
+/* automatic initial temperature: 20 times the standard deviation of the cost change	*/
+/* of 'samplesN' random swaps evaluated from the current placement (same as VPR)		*/
+double		 fpAutoInitTemp(floorplan *fp, unsigned int samplesN							){
+
+	unsigned int cellId1, cellId2;
+	unsigned int samplei;
+	double		 delta, sum=0, sumSq=0, stdDev;
+
+	if (samplesN < 2) samplesN = 2;
+
+	/* a single site (or no cell) has no swap to sample; as for a flat landscape */
+	if (((fp->nx)*(fp->ny)<2)||(fp->cellsN==0)) return 20;
+
+	for(samplei=0;samplei<samplesN;samplei++) {
+		do { /* two different indexes, not both voids */
+			get2DiffUIntRand(&cellId1,&cellId2,0,(fp->nx)*(fp->ny)-1);
+		} while ((cellId1>=(fp->cellsN))&&(cellId2>=(fp->cellsN)));
+		delta  = fpEvaluateSwap(fp,cellId1,cellId2); /* trial only, not committed */
+		sum   += delta;
+		sumSq += delta*delta;
+	}
+	stdDev = sqrt(MAX(0,(sumSq-sum*sum/samplesN)/(samplesN-1)));
+	if (stdDev <= 0) stdDev = 1; /* flat landscape */
+
+	if (gVerbose)
+		printf("- Sampled %u swaps for initial temperature, cost change std-dev: %f\n",samplesN,stdDev);
+
+	return 20*stdDev;
+
+} /* fpAutoInitTemp */
+
+/* adaptive cooling rate (VPR): cool fast while almost all or almost no moves are		*/
+/* accepted, slowly in the productive middle band										*/
+static double fpAdaptiveCoolRate(double acceptRate, double rlim) {
+
+	if (acceptRate > 0.96)				return 0.5 ; /* random walk, cool fast	*/
+	if (acceptRate > 0.8 )				return 0.9 ;
+	if ((acceptRate > 0.15)||(rlim > 1))return 0.95; /* productive band		*/
+										return 0.8 ; /* nearly frozen			*/
+
+} /* fpAdaptiveCoolRate */
+
+/* zero-temperature greedy quench: sweep all cells, try swapping each with every site	*/
+/* within 'rlim' rows/columns and take improving swaps only, until a sweep finds none	*/
+/* returns the number of improving swaps												*/
+unsigned int fpQuench(floorplan *fp, unsigned int rlim									){
+
+	unsigned int celli, x, y, x1, y1;
+	unsigned int xmin, xmax, ymin, ymax;
+	unsigned int improveCnt = 0;
+	int			 improved   = 1;
+
+	if (rlim < 1) rlim = 1;
+
+	while (improved) { /* sweep until a local minimum */
+		improved = 0;
+		for(celli=0;celli<(fp->cellsN);celli++) {
+			x1   = fp->cellsX[celli];
+			y1   = fp->cellsY[celli];
+			xmin = (x1>rlim) ? x1-rlim : 0;
+			ymin = (y1>rlim) ? y1-rlim : 0;
+			xmax = MIN(x1+rlim,(fp->nx)-1);
+			ymax = MIN(y1+rlim,(fp->ny)-1);
+			for(y=ymin;y<=ymax;y++) {
+				for(x=xmin;x<=xmax;x++) {
+					if ((x==fp->cellsX[celli])&&(y==fp->cellsY[celli])) continue; /* own site */
+					if (fpEvaluateSwap(fp,celli,fp->siteCells[y*(fp->nx)+x]) < 0) {
+						fpCommitSwap(fp);
+						improveCnt++;
+						improved = 1;
+					}
+				}
+			}
+		}
+	}
+
+	return improveCnt;
+
+} /* fpQuench */
+
+/* fill the acceptance thresholds of a temperature: a move with cost increase 'loss'	*/
+/* is accepted if a raw random number in [0,RAND_MAX] is below table[loss], the same	*/
+/* as random()/RAND_MAX < exp(-loss/curTemp)											*/
+static void fpAcceptTable(unsigned int *table, double curTemp) {
+
+	unsigned int loss;
+
+	for(loss=0;loss<ACCEPT_TABLE_SIZE;loss++)
+		table[loss] = (unsigned int)MIN(ceil(exp(-(double)loss/curTemp)*RAND_MAX),RAND_MAX);
+
+} /* fpAcceptTable */
+
+/* Metropolis test of a cost gain (old-new) at the temperature of an acceptance table	*/
+static int fpMetropolis(int gain, double temp, unsigned int *acceptTable) {
+
+	if (gain >= 0) return 1;
+	return (-gain < ACCEPT_TABLE_SIZE) ? (getRawRand() < acceptTable[-gain])
+									   : (getFloatRand(0,1) < exp(gain/temp));
+
+} /* fpMetropolis */
+
+/* CPU time of the calling thread in seconds; other annealer threads are not counted	*/
+static double fpThreadTime() {
+
+	struct timespec now;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID,&now);
+	return now.tv_sec + now.tv_nsec*1e-9;
+
+} /* fpThreadTime */
+
+/* wall-clock time in seconds, for time budget											*/
+static double fpWallTime() {
+
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC,&now);
+	return now.tv_sec + now.tv_nsec*1e-9;
+
+} /* fpWallTime */
+
+/* time budget: rescale moves per temperature to fit the remaining schedule into the	*/
+/* remaining time at the measured move throughput. If that leaves less than cells#		*/
+/* moves per temperature, a fixed cooling rate is raised to reach freezing in time		*/
+static void fpBudgetRescale(floorplan *fp, double elapsed, double movesCnt, double curTemp,
+							double freezingTemp, double coolFactor,
+							unsigned int *movesPerTemp, double *coolingRate				) {
+
+	double rate      = movesCnt/MAX(elapsed,1e-6);		/* moves per second			*/
+	double movesLeft = rate*(gTimeBudget-elapsed);		/* moves that fit in budget	*/
+	double minMoves  = MAX(fp->cellsN,1);
+	double tempsLeft = 1;								/* temperatures to freezing	*/
+	double moves;
+
+	if ((curTemp>freezingTemp)&&(coolFactor<1))
+		tempsLeft = MAX(1,log(freezingTemp/curTemp)/log(coolFactor));
+	moves = movesLeft/tempsLeft;
+
+	if (moves < minMoves) { /* not enough time, cool faster */
+		moves = minMoves;
+		if (*coolingRate>0) {
+			tempsLeft	 = MAX(1,movesLeft/minMoves);
+			*coolingRate = (curTemp>freezingTemp) ? exp(log(freezingTemp/curTemp)/tempsLeft) : *coolingRate;
+		}
+	}
+	*movesPerTemp = (unsigned int)MIN(moves,UINT_MAX);
+
+} /* fpBudgetRescale */
+
+/* throughput probe: evaluate (not commit) random swaps, as many as cells and at least	*/
+/* 1000, same as fpAutoInitTemp. The random numbers state is restored, so probing never	*/
+/* changes placement. Returns the swaps evaluated, 0 on a single site (or no cell)		*/
+static unsigned int fpSwapProbe(floorplan *fp) {
+
+	unsigned int cellId1, cellId2;
+	unsigned int samplesN = MAX(fp->cellsN,1000);
+	unsigned int samplei;
+	randState	 randSaved;
+
+	if (((fp->nx)*(fp->ny)<2)||(fp->cellsN==0)) return 0;
+
+	getRandState(&randSaved);
+	for(samplei=0;samplei<samplesN;samplei++) {
+		do {
+			get2DiffUIntRand(&cellId1,&cellId2,0,(fp->nx)*(fp->ny)-1);
+		} while ((cellId1>=(fp->cellsN))&&(cellId2>=(fp->cellsN)));
+		fpEvaluateSwap(fp,cellId1,cellId2);
+	}
+	setRandState(&randSaved);
+	return samplesN;
+
+} /* fpSwapProbe */
+
+/* expected effort, reported before annealing: temperatures to freezing at a			*/
+/* fixed cooling rate, total moves, and runtime from the timed throughput of trial		*/
+/* swaps (fpSwapProbe)																	*/
+static void fpEffortEstimate(floorplan *fp, unsigned int movesPerTemp, double initTemp,
+							 double coolingRate, double freezingTemp						) {
+
+	unsigned int samplesN;
+	double		 tempsN, movesN, rate = 0;
+	double		 startTime = fpThreadTime();
+
+	samplesN = fpSwapProbe(fp);
+	if (samplesN>0) rate = samplesN/MAX(fpThreadTime()-startTime,1e-6);
+
+	if ((coolingRate<=0)||(coolingRate>=1)) {
+		printf("\tExpected Moves        : %u per temperature, total n/a (adaptive cooling)\n",
+			   movesPerTemp);
+		return;
+	}
+	tempsN = (initTemp>freezingTemp) ? ceil(log(freezingTemp/initTemp)/log(coolingRate)) : 1;
+	movesN = tempsN*movesPerTemp;
+	printf("\tExpected Moves        : %.0f (%.0f temperatures)\n",movesN,tempsN);
+	if (rate>0)
+		 printf("\tExpected Runtime      : %.1fs (at %.0f moves/second)\n",movesN/rate,rate);
+	else printf("\tExpected Runtime      : n/a (no swap to sample)\n");
+
+} /* fpEffortEstimate */
+
+/* undo journaled swaps on a cells order, in reverse; a swap is its own inverse		*/
+static void fpJournalUndo(unsigned int *order, unsigned int *journal, unsigned int journalN) {
+
+	unsigned int tmp;
+
+	while (journalN > 0) {
+		journalN -= 2;
+		tmp						   = order[journal[journalN  ]];
+		order[journal[journalN  ]] = order[journal[journalN+1]];
+		order[journal[journalN+1]] = tmp;
+	}
+
+} /* fpJournalUndo */
+
+/* best-solution journal: record a committed swap since the last best placement. Once	*/
+/* the journal holds a swap per site, the best is materialized into bestOrder instead	*/
+/* and journaling stops until the next best; keeps both memory and work O(sites)		*/
+static void fpJournalPush(floorplan *fp, unsigned int cellId1, unsigned int cellId2,
+						  unsigned int *journal, unsigned int *journalN,
+						  unsigned int *bestOrder, int *bestSaved						) {
+
+	unsigned int sitesN = (fp->nx)*(fp->ny);
 
-	double curTemp = initTemp;
+	if (*bestSaved) return; /* best already materialized */
 
-	arrCopy(fp->cellsOrder,bestOrder,maxInd+1);
+	journal[(*journalN)++] = cellId1;
+	journal[(*journalN)++] = cellId2;
+	if (*journalN >= 2*sitesN) { /* full, best = current with journal undone */
+		arrCopy(fp->cellsOrder,bestOrder,sitesN);
+		fpJournalUndo(bestOrder,journal,*journalN);
+		*journalN  = 0;
+		*bestSaved = 1;
+	}
+
+} /* fpJournalPush */
+
+/* cooling schedule of an annealing engine: temperature, range limiter, convergence,	*/
+/* and time budget state, shared by the serial and the parallel cooling engines			*/
+typedef struct {
+	unsigned int movesPerTemp;	/* moves per temperature, rescaled by time budget	*/
+	double		 initTemp, freezingTemp;
+	double		 curTemp;		/* current temperature								*/
+	double		 coolingRate;	/* fixed cooling rate, 0: adaptive					*/
+	double		 coolFactor;	/* last applied cooling factor						*/
+	double		 rlim;			/* range limit										*/
+	unsigned int rlimMax;
+	double		 acceptRate;	/* acceptance ratio of last temperature				*/
+	unsigned int movesDone;		/* moves done in last temperature					*/
+	double		 movesCnt;		/* total moves										*/
+	unsigned int tempsCnt;		/* temperatures count								*/
+	unsigned int stepsCnt;		/* temperatures since last refresh					*/
+	unsigned int bestCost;		/* best cost, kept by the engine					*/
+	unsigned int stepBestCost;	/* best cost before current temperature				*/
+	unsigned int noImproveCnt;	/* temperatures without a new best cost				*/
+	double		 cpuStart;		/* thread CPU start, for throughput report			*/
+	double		 wallStart;		/* wall-clock start, for time budget				*/
+	int			 verbose, gui;
+} fpSchedule;
+
+/* initialize the cooling schedule of an annealing engine on fp							*/
+static void fpScheduleInit(floorplan *fp, fpSchedule *sch, unsigned int movesPerTemp,
+						   double initTemp, double coolingRate, double freezingTemp		) {
+
+	sch->movesPerTemp = movesPerTemp;
+	sch->initTemp	  = initTemp;
+	sch->freezingTemp = freezingTemp;
+	sch->curTemp	  = initTemp;
+	sch->coolingRate  = coolingRate;
+	sch->coolFactor	  = (coolingRate>0) ? coolingRate : 0.9;
+	sch->rlimMax	  = MAX(fp->nx,fp->ny);
+	sch->rlim		  = (gRangeLimit>0) ? MIN(gRangeLimit,sch->rlimMax) : sch->rlimMax;
+	sch->acceptRate	  = 1;
+	sch->movesDone	  = 0;
+	sch->movesCnt	  = 0;
+	sch->tempsCnt	  = 0;
+	sch->stepsCnt	  = 0;
+	sch->bestCost	  = fp->bbox;
+	sch->stepBestCost = fp->bbox;
+	sch->noImproveCnt = 0;
+	sch->verbose	  = gVerbose && !fp->quiet; /* annealer threads are quiet */
+	sch->gui		  = gGUI	 && !fp->quiet;
+
+} /* fpScheduleInit */
+
+/* directed moves probability of the current temperature, growing with log(temperature)	*/
+static double fpScheduleDirected(fpSchedule *sch) {
+
+	if (sch->initTemp <= sch->freezingTemp) return 0;
+	return gDirectedProb*MIN(1,log(sch->initTemp/sch->curTemp)/log(sch->initTemp/sch->freezingTemp));
+
+} /* fpScheduleDirected */
+
+/* start of a cooling schedule: report the parameters (after the engine's own header),	*/
+/* show the initial placement, and start the timers. 'label' prefixes the GUI header;	*/
+/* 'estimate' adds the expected effort of a serial run									*/
+static void fpScheduleStart(floorplan *fp, fpSchedule *sch, const char *label, int estimate) {
+
+	unsigned int probeN;
+	double		 probeStart;
+
+	/* time budget: fit the schedule, first temperature included, to the throughput of	*/
+	/* probe swaps; later temperatures are refit to the measured one (fpScheduleStep).	*/
+	/* A parallel engine, faster than the probe, is sized low until its first refit		*/
+	if (gTimeBudget>0) {
+		probeStart = fpWallTime();
+		probeN	   = fpSwapProbe(fp);
+		if (probeN>0)
+			fpBudgetRescale(fp,fpWallTime()-probeStart,probeN,sch->curTemp,sch->freezingTemp,
+							sch->coolFactor,&sch->movesPerTemp,&sch->coolingRate);
+	}
 
-	gLogCurTemp	  = log(curTemp)/log(10);
-	gInitCost	  = fp->bbox    ;
-	gCurCost	  = gInitCost   ;
+	if (!fp->quiet) {
+		gLogCurTemp	= log(sch->curTemp)/log(10);
+		gInitCost	= fp->bbox;
+		gCurCost	= gInitCost;
+	}
 
-	if (gVerbose) {
-		printf("Performing simulated annealing with the following parameters:\n");
-		printf("\tInitial Temperature   : %f\n",curTemp);
-		printf("\tFreezing Temperature  : %f\n",freezingTemp);
-		printf("\tCooling Rate          : %f\n",coolingRate);
-		printf("\tMoves per Temperature : %u\n\n",movesPerTemp);
+	if (sch->verbose) {
+		printf("\tInitial Temperature   : %f\n",sch->initTemp);
+		printf("\tFreezing Temperature  : %f\n",sch->freezingTemp);
+		if (sch->coolingRate>0)
+			 printf("\tCooling Rate          : %f\n",sch->coolingRate);
+		else printf("\tCooling Rate          : adaptive\n");
+		printf("\tMoves per Temperature : %u\n",sch->movesPerTemp);
+		if (estimate)
+			fpEffortEstimate(fp,sch->movesPerTemp,sch->initTemp,sch->coolingRate,sch->freezingTemp);
+		printf("\tRange Limit           : %u\n",(unsigned int)sch->rlim);
+		printf("\tTarget Acceptance     : %f\n",gAcceptTarget);
+		printf("\tEquilibrium Detection : %s\n",gEquilibrium ? "on" : "off");
+		printf("\tNo Improvement Exit   : %u\n",gNoImprove);
+		printf("\tShift Moves           : %f\n",(fp->cellsN<(fp->nx)*(fp->ny)) ? MIN(MAX(gShiftProb,0),1) : 0);
+		if (gBandit)
+			 printf("\tMove Types Mix        : adaptive\n");
+		else printf("\tDirected Moves        : up to %f\n",MIN(MAX(gDirectedProb,0),1));
+		printf("\tGreedy Quench         : %s\n",gQuench ? "on" : "off");
+		if (gTimeBudget>0)
+			 printf("\tTime Budget           : %.2fs\n\n",gTimeBudget);
+		else printf("\tTime Budget           : none\n\n");
 	}
 
-	if (gGUI) {
+	if (sch->gui) {
 		/* update global message and wait for 'Proceed' to proceed */
 		sprintf(gFooterLabel,"Initial floorplan. Press 'Proceed' to continue.");
-		sprintf(gHeaderLabel,"InitialTemp:%.1e  FreezingTemp:%.1e  CoolingRate:.%d  MovesPerTemp:%u" ,
-					initTemp, freezingTemp, (int)(coolingRate*100), movesPerTemp      );
+		sprintf(gHeaderLabel,"%sInitialTemp:%.1e  FreezingTemp:%.1e  CoolingRate:.%d  MovesPerTemp:%u",
+					label, sch->initTemp, sch->freezingTemp, (int)(sch->coolingRate*100), sch->movesPerTemp);
 		waitLoop();
 		if (gPostScript) postscript(drawScreen);
 	}
 
-	while(curTemp>freezingTemp) {
+	sch->cpuStart  = fpThreadTime();
+	sch->wallStart = fpWallTime();
 
-			if (stepsCnt == gRefreshRate-1) {
-				if (gVerbose) printf("- Current temperature: %e, Cost: %u\n",curTemp,fp->bbox);
-				if (gGUI) {
-					/* update global message and wait for 'Proceed' to proceed */
-					sprintf(gFooterLabel,"Current temperature: %e, Cost: %u",curTemp,fp->bbox);
-					waitLoop();
-					if (gPostScript) postscript(drawScreen);
-				}
-				stepsCnt=0;
-			} else	stepsCnt++;
-
-		for(imove=1;imove<=movesPerTemp;imove++) {
-			oldCost = fp->bbox;
-			/* get two diffrerent random indexes */
-			get2DiffUIntRand(&cellId1,&cellId2,0,maxInd);
-			fpSwapCells(fp,cellId1,cellId2);	/* swap */
-			newCost = fp->bbox;
-			gain = oldCost-newCost;
+} /* fpScheduleStart */
+
+/* progress report every gRefreshRate temperatures; waits for 'Proceed' in GUI mode		*/
+static void fpScheduleRefresh(floorplan *fp, fpSchedule *sch) {
+
+	unsigned int moveType;
+
+	if (sch->stepsCnt != gRefreshRate-1) {
+		sch->stepsCnt++;
+		return;
+	}
+	sch->stepsCnt = 0;
+	if (sch->verbose) printf("- Current temperature: %e, Cost: %u, Acceptance: %.3f, Range limit: %u, Moves: %u\n",
+								sch->curTemp,fp->bbox,sch->acceptRate,(unsigned int)sch->rlim,sch->movesDone);
+	if (sch->verbose && gBandit) {
+		printf("  Move types mix:");
+		for(moveType=0;moveType<MOVE_TYPES;moveType++)
+			printf(" %s %.3f",fpMoveNames[moveType],fp->moveProb[moveType]);
+		printf("\n");
+	}
+	if (sch->gui) {
+		/* update global message and wait for 'Proceed' to proceed */
+		sprintf(gFooterLabel,"Current temperature: %e, Cost: %u",sch->curTemp,fp->bbox);
+		waitLoop();
+		if (gPostScript) postscript(drawScreen);
+	}
+
+} /* fpScheduleRefresh */
+
+/* end of a temperature: account its moves, then cool, fit the remaining schedule into	*/
+/* the time budget, and update the range limiter. Returns 1 to stop annealing: time		*/
+/* budget exhausted, or no new best cost for gNoImprove temperatures					*/
+static int fpScheduleStep(floorplan *fp, fpSchedule *sch, unsigned int acceptCnt, unsigned int movesDone) {
+
+	sch->movesDone	 = movesDone;
+	sch->movesCnt	+= movesDone;
+	sch->tempsCnt++;
+	sch->acceptRate	 = (double)acceptCnt/MAX(movesDone,1);
+
+	if ((gTimeBudget>0)&&(fpWallTime()-sch->wallStart>=gTimeBudget)) {
+		if (sch->verbose) printf("- Time budget exhausted at temperature %e\n",sch->curTemp);
+		return 1;
+	}
+
+	/* cool; fixed rate, or adaptive to the acceptance ratio if coolingRate is 0 */
+	sch->coolFactor	 = (sch->coolingRate>0) ? sch->coolingRate : fpAdaptiveCoolRate(sch->acceptRate,sch->rlim);
+	sch->curTemp	*= sch->coolFactor;
+
+	/* fit the remaining schedule into the time budget */
+	if (gTimeBudget>0)
+		fpBudgetRescale(fp,fpWallTime()-sch->wallStart,sch->movesCnt,sch->curTemp,sch->freezingTemp,
+						sch->coolFactor,&sch->movesPerTemp,&sch->coolingRate);
+
+	/* range limiter (VPR): shrink/grow the window to keep acceptance near target */
+	if (gAcceptTarget>0) {
+		sch->rlim *= 1-gAcceptTarget+sch->acceptRate;
+		sch->rlim  = MAX(1,MIN(sch->rlim,sch->rlimMax));
+	}
+
+	if (!fp->quiet) {
+		gCurCost	= fp->bbox;
+		gLogCurTemp	= log(sch->curTemp)/log(10);
+	}
+
+	/* converged: best cost not improved for gNoImprove frozen temperatures */
+	if ((sch->bestCost<sch->stepBestCost)||(fp->bbox>sch->bestCost*(1+CONVERGE_TOLERANCE)))
+		 sch->noImproveCnt = 0;
+	else sch->noImproveCnt++;
+	sch->stepBestCost = sch->bestCost;
+	if ((gNoImprove>0)&&(sch->noImproveCnt>=gNoImprove)) {
+		if (sch->verbose) printf("- No improvement for %u temperatures, stopping at temperature %e\n",
+									sch->noImproveCnt,sch->curTemp);
+		return 1;
+	}
+	return 0;
+
+} /* fpScheduleStep */
+
+/* end of annealing, once the engine restored its best placement into cellsOrder:		*/
+/* recompute locations and costs, quench greedily, and report the final cost.			*/
+/* Returns the thread CPU time since cpuStart											*/
+static double fpAnnealFinish(floorplan *fp, unsigned int rlim, double cpuStart, double wallStart) {
+
+	unsigned int startCost, improvesN;
+	double		 cpuTime;
+	int			 verbose = gVerbose && !fp->quiet;
+	int			 gui	 = gGUI		&& !fp->quiet;
+
+	fpCellsUpdateLoc(fp);
+	fpAllNetsUpdateBBox(fp);
+
+	/* zero-temperature greedy quench from the best placement */
+	if (gQuench) {
+		startCost = fp->bbox;
+		improvesN = fpQuench(fp,MAX(rlim,QUENCH_MIN_RLIM));
+		if (verbose) printf("- Greedy quench: %u improving moves, cost %u -> %u\n",improvesN,startCost,fp->bbox);
+	}
+	cpuTime = fpThreadTime()-cpuStart;
+
+	/* finished! wait still until 'Exit' is pressed; one of several annealers leaves	*/
+	/* the final report to fpAnnealMultiStart											*/
+	if (gui && !fp->partial) {
+		/* update global message and wait for 'Proceed' to proceed */
+		sprintf(gFooterLabel,"Finished! Final cost: %u - press 'Exit'", fp->bbox);
+		waitLoop();
+		if (gPostScript) postscript(drawScreen);
+	}
+	if (verbose) {
+		if (fp->partial)
+			 printf("- Annealer finished with cost: %u\n", fp->bbox);
+		else printf("- Finished with final cost: %u\n", fp->bbox);
+		printf("- Wall time: %.2fs\n", fpWallTime()-wallStart);
+	}
+	return cpuTime;
+
+} /* fpAnnealFinish */
+
+/* simulated annealing placement 											*/
+void fpAnneal(floorplan *fp, unsigned int movesPerTemp, double initTemp		,
+							 double coolingRate	      , double freezingTemp	){
+
+	fpSchedule	 sch;
+	unsigned int cellId1,cellId2;
+	unsigned int moveType;
+	unsigned int imove;
+	unsigned int blockType = 0;		/* bandit: move type of the timed block	 */
+	unsigned int blockLeft;			/* bandit: moves left in the timed block */
+	double		 blockGain = 0;		/* bandit: timed block improvement	 */
+	double		 blockStart = 0;	/* bandit: timed block start, seconds	 */
+	unsigned int maxInd = (fp->nx)*(fp->ny)-1;
+	unsigned int acceptCnt;			/* accepted moves in current temperature */
+	unsigned int eqWindow   = MAX(fp->cellsN,EQ_MIN_WINDOW); /* equilibrium window */
+	double		 winSum, winSumSq;	/* cost sum and squares sum in window	 */
+	double		 winMean, winStd;	/* cost mean and std-dev in window		 */
+	double		 prevMean;			/* cost mean in previous window			 */
+	unsigned int prevAccept;		/* accepted moves until previous window	 */
+	unsigned int newCost;
+	int gain;
+	double		 cpuTime;
+	unsigned int *bestOrder = arrAlloc(maxInd+1);	 /* best snapshot, if bestSaved */
+	unsigned int *journal   = arrAlloc(2*(maxInd+1));/* swaps since best placement	*/
+	unsigned int  journalN  = 0;
+	int			  bestSaved = 0;
+	unsigned int *acceptTable = arrAlloc(ACCEPT_TABLE_SIZE); /* uphill thresholds	*/
+
+	fpScheduleInit(fp,&sch,movesPerTemp,initTemp,coolingRate,freezingTemp);
+
+	/* move types mix; directed moves rise from none as temperature drops */
+	if (gBandit)
+		 fpBanditMix(fp);
+	else fpMoveMix(fp,0);
+
+	if (sch.verbose) printf("Performing simulated annealing with the following parameters:\n");
+	fpScheduleStart(fp,&sch,"",1);
+
+	while(sch.curTemp>sch.freezingTemp) {
+
+		fpScheduleRefresh(fp,&sch);
+
+		/* learned mix, or directed moves probability growing with log(temperature) */
+		if (gBandit)
+			fpBanditMix(fp);
+		else if ((gDirectedProb>0)&&(initTemp>freezingTemp))
+			fpMoveMix(fp,fpScheduleDirected(&sch));
+
+		fpAcceptTable(acceptTable,sch.curTemp);
+
+		acceptCnt  = 0;
+		prevAccept = 0;
+		prevMean   = -1;
+		winSum     = 0;
+		winSumSq   = 0;
+		blockLeft  = 0;				/* a block cut by the temperature end is dropped */
+		for(imove=1;imove<=sch.movesPerTemp;imove++) {
+			if (gBandit&&(blockLeft==0)&&((imove%BANDIT_SAMPLE)==0)) {
+				blockType  = fpPickMoveType(fp);
+				blockLeft  = BANDIT_BLOCK;
+				blockGain  = 0;
+				blockStart = fpThreadTime();
+			}
+
+			/* get a cell and a different cell or void, second site in range */
+			if (blockLeft>0)
+				moveType = fpProposeMoveOf(fp,blockType,(unsigned int)sch.rlim,&cellId1,&cellId2);
+			else moveType = fpProposeMove(fp,(unsigned int)sch.rlim,&cellId1,&cellId2);
+			gain = -fpEvaluateSwap(fp,cellId1,cellId2);	/* trial swap */
 			if (gain < 0) {
-				if (getFloatRand(0,1) >= exp(gain/curTemp))
-					fpSwapCells(fp,cellId1,cellId2);	/* undo swapping by swapping again*/
+				if (fpMetropolis(gain,sch.curTemp,acceptTable)) {
+					fpCommitSwap(fp);	/* bad move taken */
+					fpJournalPush(fp,cellId1,cellId2,journal,&journalN,bestOrder,&bestSaved);
+					fp->moveAccepted[moveType]++;
+					acceptCnt++;
+				}
 			} else { /* cost is improved */
-				if (newCost<bestCost) {
-					arrCopy(fp->cellsOrder,bestOrder,maxInd+1);
-					bestCost = newCost;
+				fpCommitSwap(fp);
+				fp->moveAccepted[moveType]++;
+				acceptCnt++;
+				newCost = fp->bbox;
+				if (newCost<sch.bestCost) { /* new best, O(1) */
+					journalN	 = 0;
+					bestSaved	 = 0;
+					sch.bestCost = newCost;
+				} else fpJournalPush(fp,cellId1,cellId2,journal,&journalN,bestOrder,&bestSaved);
+			}
+
+			/* bandit credit: improvement and time of the whole timed block */
+			if (blockLeft>0) {
+				blockGain += MAX(gain,0);
+				if (--blockLeft==0) {
+					fp->banditGain[blockType] += blockGain;
+					fp->banditTime[blockType] += fpThreadTime()-blockStart;
+				}
+			}
+
+			/* time budget exhausted; checked every 1024 moves */
+			if ((gTimeBudget>0)&&((imove&1023)==0)&&(fpWallTime()-sch.wallStart>=gTimeBudget))
+				break;
+
+			/* equilibrium detection; movesPerTemp is the hard cap */
+			if (gEquilibrium) {
+				winSum   += fp->bbox;
+				winSumSq += (double)(fp->bbox)*(fp->bbox);
+				if (imove%eqWindow == 0) {
+					winMean = winSum/eqWindow;
+					winStd  = sqrt(MAX(0,winSumSq/eqWindow-winMean*winMean));
+					if ((acceptCnt == prevAccept) || /* frozen, nothing accepted in window */
+						((prevMean >= 0) && (fabs(winMean-prevMean) <= EQ_TOLERANCE*winStd))) break;
+					prevMean   = winMean;
+					prevAccept = acceptCnt;
+					winSum     = 0;
+					winSumSq   = 0;
 				}
 			}
 		}
 
-		gCurCost	 = fp->bbox    ;
-		curTemp     *= coolingRate ;
-		gLogCurTemp	 = log(curTemp)/log(10);
+		if (fpScheduleStep(fp,&sch,acceptCnt,MIN(imove,sch.movesPerTemp))) break;
+	}
+	/* restore best placement */
+	if (bestSaved)
+		 arrCopy(bestOrder,fp->cellsOrder,maxInd+1);
+	else fpJournalUndo(fp->cellsOrder,journal,journalN);
+	cpuTime = fpAnnealFinish(fp,(unsigned int)sch.rlim,sch.cpuStart,sch.wallStart);
+
+	if (sch.verbose) {
+		printf("- Moves: %.0f, CPU time: %.2fs, moves/second: %.0f\n",
+					sch.movesCnt, cpuTime, (cpuTime>0) ? sch.movesCnt/cpuTime : 0);
+		printf("- Temperatures: %u, average moves per temperature: %.0f\n",
+					sch.tempsCnt, (sch.tempsCnt>0) ? sch.movesCnt/sch.tempsCnt : 0);
+		for(moveType=0;moveType<MOVE_TYPES;moveType++)
+			printf("- %s moves: proposed %.0f, accepted %.0f (%.3f), final mix %.3f\n",fpMoveNames[moveType],
+					fp->moveProposed[moveType],fp->moveAccepted[moveType],
+					(fp->moveProposed[moveType]>0) ? fp->moveAccepted[moveType]/fp->moveProposed[moveType] : 0,
+					fp->moveProb[moveType]);
+	}
+
+	safeFree(bestOrder);
+	safeFree(journal);
+	safeFree(acceptTable);
+
+} /* fpAnneal */
+
+/* multi-start annealing thread job: anneal a private floorplan copy					*/
+typedef struct {
+	floorplan	*fp;
+	unsigned int stream;		/* random stream of the thread		*/
+	unsigned int movesPerTemp;
+	double		 initTemp, coolingRate, freezingTemp;
+} fpAnnealJob;
+
+/* multi-start annealing thread: seed its own random stream and anneal					*/
+static void *fpAnnealThread(void *arg) {
+
+	fpAnnealJob *job = (fpAnnealJob*)arg;
+
+	setRandSeed(gSeed,job->stream);
+	fpAnneal(job->fp,job->movesPerTemp,job->initTemp,job->coolingRate,job->freezingTemp);
+	return NULL;
+
+} /* fpAnnealThread */
+
+/* multi-start annealing: 'threadsN' independent annealers, each on a private copy of	*/
+/* the placement with its own random stream; the best final placement is kept in fp		*/
+void fpAnnealMultiStart(floorplan *fp, unsigned int threadsN,
+						unsigned int movesPerTemp, double initTemp,
+						double coolingRate		 , double freezingTemp					) {
+
+	fpAnnealJob	*jobs	 = (fpAnnealJob*)safeMalloc(sizeof(fpAnnealJob)*threadsN);
+	pthread_t	*threads = (pthread_t*)safeMalloc(sizeof(pthread_t)*threadsN);
+	unsigned int threadi, besti = 0;
+	int			 verbose = gVerbose && !fp->quiet;
+	int			 gui	 = gGUI		&& !fp->quiet;
+
+	/* thread 0 is the calling thread on fp itself, the only one drawing and reporting */
+	for(threadi=0;threadi<threadsN;threadi++) {
+		jobs[threadi].fp		   = (threadi==0) ? fp : fpClone(fp);
+		jobs[threadi].stream	   = threadi+1; /* stream 0 placed the cells */
+		jobs[threadi].movesPerTemp = movesPerTemp;
+		jobs[threadi].initTemp	   = initTemp;
+		jobs[threadi].coolingRate  = coolingRate;
+		jobs[threadi].freezingTemp = freezingTemp;
+	}
+	for(threadi=1;threadi<threadsN;threadi++)
+		if (pthread_create(&threads[threadi],NULL,fpAnnealThread,&jobs[threadi]) != 0) {
+			printf("-E- Failed creating annealing thread %u! Exiting...\n",threadi);
+			exit(-1);
+		}
+	fp->partial = 1;
+	fpAnnealThread(&jobs[0]);
+	fp->partial = 0;
+	for(threadi=1;threadi<threadsN;threadi++)
+		pthread_join(threads[threadi],NULL);
+
+	/* keep the best placement */
+	for(threadi=1;threadi<threadsN;threadi++)
+		if (jobs[threadi].fp->bbox < jobs[besti].fp->bbox) besti = threadi;
+	if (verbose) {
+		printf("- Multi-start final costs:");
+		for(threadi=0;threadi<threadsN;threadi++) printf(" %u",jobs[threadi].fp->bbox);
+		printf("\n- Best of %u annealers: thread %u, cost %u\n",threadsN,besti,jobs[besti].fp->bbox);
+	}
+	if (besti != 0) {
+		arrCopy(jobs[besti].fp->cellsOrder,fp->cellsOrder,(fp->nx)*(fp->ny));
+		fpCellsUpdateLoc(fp);
+		fpAllNetsUpdateBBox(fp);
 	}
-	arrCopy(bestOrder,fp->cellsOrder,maxInd+1);
-	fpAllNetsUpdateBBox(fp);
 
 	/* finished! wait still until 'Exit' is pressed */
-	if (gGUI) {
+	if (gui) {
 		/* update global message and wait for 'Proceed' to proceed */
 		sprintf(gFooterLabel,"Finished! Final cost: %u - press 'Exit'", fp->bbox);
 		waitLoop();
 		if (gPostScript) postscript(drawScreen);
 	}
-	if (gVerbose) printf("- Finished with final cost: %u\n", fp->bbox);
+	if (verbose) printf("- Finished with final cost: %u\n", fp->bbox);
+
+	for(threadi=1;threadi<threadsN;threadi++)
+		fpDelete(jobs[threadi].fp);
+	safeFree(jobs);
+	safeFree(threads);
+
+} /* fpAnnealMultiStart */
+
+/* parallel sweeps: shared state of the threads of a parallel engine					*/
+typedef struct {
+	pthread_barrier_t start;	/* threads start a sweep			*/
+	pthread_barrier_t done;		/* threads finished a sweep			*/
+	int				  stop;		/* no more sweeps					*/
+	floorplan		 *master;	/* regions: the merged placement	*/
+	struct fpSweepJobStruct *jobs;	/* tempering: replicas			*/
+	unsigned int	  jobsN;	/* tempering: replicas count		*/
+	unsigned int	  threadsN;	/* tempering: threads				*/
+} fpSweepCtl;
+
+/* parallel sweep of a thread: Metropolis moves on a private floorplan at a fixed		*/
+/* temperature (a tempering replica at its rung, or a region of the placement)			*/
+typedef struct fpSweepJobStruct {
+	fpSweepCtl	*ctl;
+	floorplan	*fp;
+	unsigned int stream;		/* random stream of the thread		*/
+	randState	 rand;			/* tempering: replica stream		*/
+	unsigned int rung;			/* tempering: rung in the ladder	*/
+	double		 temp;			/* temperature of the sweep			*/
+	double		 directedProb;	/* directed moves probability		*/
+	unsigned int rlim;			/* range limit						*/
+	unsigned int moves;			/* moves per sweep					*/
+	unsigned int accepted;		/* accepted moves in last sweep		*/
+	unsigned int *acceptTable;	/* uphill thresholds at temp		*/
+	unsigned int *bestOrder;	/* best placement, NULL: not kept	*/
+	unsigned int bestCost;
+} fpSweepJob;
+
+/* parallel sweep: Metropolis moves at the fixed temperature of the job; the best		*/
+/* placement, if kept, is checked at the end of the sweep								*/
+static void fpSweep(fpSweepJob *job) {
+
+	floorplan	*fp = job->fp;
+	unsigned int cellId1, cellId2;
+	unsigned int moveType, imove;
+	int			 gain;
+
+	fpMoveMix(fp,job->directedProb);
+	fpAcceptTable(job->acceptTable,job->temp);
+	job->accepted = 0;
+	for(imove=0;imove<job->moves;imove++) {
+		moveType = fpProposeMove(fp,job->rlim,&cellId1,&cellId2);
+		gain	 = -fpEvaluateSwap(fp,cellId1,cellId2);
+		if (fpMetropolis(gain,job->temp,job->acceptTable)) {
+			fpCommitSwap(fp);
+			fp->moveAccepted[moveType]++;
+			job->accepted++;
+		}
+	}
+	if ((job->bestOrder != NULL) && (fp->bbox < job->bestCost)) {
+		job->bestCost = fp->bbox;
+		arrCopy(fp->cellsOrder,job->bestOrder,(fp->nx)*(fp->ny));
+	}
+
+} /* fpSweep */
+
+/* parallel tempering: sweep the replicas of a thread, every threadsN-th one from the	*/
+/* given one, each on its own random stream; the thread's own stream is kept			*/
+static void fpTemperSweeps(fpSweepJob *job) {
+
+	fpSweepCtl	*ctl = job->ctl;
+	unsigned int jobi;
+	randState	 saved;
+
+	getRandState(&saved);
+	for(jobi=(unsigned int)(job-ctl->jobs);jobi<ctl->jobsN;jobi+=ctl->threadsN) {
+		setRandState(&ctl->jobs[jobi].rand);
+		fpSweep(&ctl->jobs[jobi]);
+		getRandState(&ctl->jobs[jobi].rand);
+	}
+	setRandState(&saved);
+
+} /* fpTemperSweeps */
+
+/* parallel tempering thread: sweep its replicas whenever the exchanges release it		*/
+static void *fpTemperThread(void *arg) {
 
+	fpSweepJob *job = (fpSweepJob*)arg;
+
+	while (1) {
+		pthread_barrier_wait(&job->ctl->start);
+		if (job->ctl->stop) break;
+		fpTemperSweeps(job);
+		pthread_barrier_wait(&job->ctl->done);
+	}
+	return NULL;
+
+} /* fpTemperThread */
+
+/* parallel tempering (replica exchange): replicas anneal at a ladder of temperatures	*/
+/* from rung 0 down to freezingTemp, a rung every TEMPER_GAP of log-temperature, shared	*/
+/* among 'threadsN' threads. The top rung is initTemp, though never hotter than the		*/
+/* cost change std-dev (fpAutoInitTemp/20), where most moves are still accepted; rungs	*/
+/* hotter than that only random walk. Per round, the replicas share the work of			*/
+/* movesPerTemp moves per thread; then neighbour rungs (even and odd pairs alternately)	*/
+/* exchange replicas with probability min(1,exp(dBeta*dCost)), and the rung spacing		*/
+/* adapts to the exchange ratios (TEMPER_ADAPT). Runs as many rounds as the cooling		*/
+/* schedule has temperatures; the best placement of all replicas is kept in fp			*/
+void fpTemper(floorplan *fp, unsigned int threadsN, unsigned int movesPerTemp, double initTemp,
+			  double coolingRate, double freezingTemp										) {
+
+	fpSweepCtl	 ctl;
+	fpSweepJob	*jobs;
+	fpSweepJob	*tmpJob;
+	fpSweepJob **rungJobs;		/* replica at each rung				*/
+	pthread_t	*threads;
+	double		*rungTemp, *rungRlim;
+	double		*rungMoves, *rungAccepted, *exchTried, *exchAccepted;
+	double		*winTried, *winAccepted;	/* exchanges since the last adaptation	*/
+	double		 gap, gapsSum, exchMean;
+	unsigned int sitesN	 = (fp->nx)*(fp->ny);
+	unsigned int rlimMax = MAX(fp->nx,fp->ny);
+	unsigned int replicasN, sweepMoves;
+	unsigned int roundsN, roundi, rungi, threadi, besti = 0;
+	unsigned int bestCost, noImproveCnt = 0, refreshCnt = 0;
+	double		 dBetaCost, wallStart, cpuStart, cpuTime, elapsed;
+	int			 verbose = gVerbose && !fp->quiet;
+	int			 gui	 = gGUI		&& !fp->quiet;
+
+	if (threadsN < 2) threadsN = TEMPER_THREADS;
+	if ((coolingRate>0)&&(coolingRate<1))
+		 roundsN = (initTemp>freezingTemp) ? (unsigned int)ceil(log(freezingTemp/initTemp)/log(coolingRate)) : 1;
+	else roundsN = TEMPER_ROUNDS;
+	if (sitesN < 2) roundsN = 0; /* a single site has no move */
+
+	/* ladder top: at most the cost change std-dev; bottom: below 1/ln(RAND_MAX) no unit	*/
+	/* cost increase is accepted (greedy). A rung every TEMPER_GAP, every thread busy		*/
+	initTemp	 = MIN(initTemp,fpAutoInitTemp(fp,fp->cellsN)/20);
+	initTemp	 = MAX(initTemp,1/log(RAND_MAX));
+	freezingTemp = MIN(initTemp,MAX(freezingTemp,1/log(RAND_MAX)));
+	replicasN	 = (unsigned int)MIN(TEMPER_MAX_RUNGS,ceil(log(initTemp/freezingTemp)/TEMPER_GAP)+1);
+	replicasN	 = MAX(replicasN,threadsN);
+	sweepMoves	 = (unsigned int)MIN(UINT_MAX,MAX(1,(double)movesPerTemp*threadsN/replicasN));
+
+	jobs		 = (fpSweepJob*)safeMalloc(sizeof(fpSweepJob)*replicasN);
+	rungJobs	 = (fpSweepJob**)safeMalloc(sizeof(fpSweepJob*)*replicasN);
+	threads		 = (pthread_t*)safeMalloc(sizeof(pthread_t)*threadsN);
+	rungTemp	 = (double*)safeMalloc(sizeof(double)*replicasN);
+	rungRlim	 = (double*)safeMalloc(sizeof(double)*replicasN);
+	rungMoves	 = (double*)safeMalloc(sizeof(double)*replicasN);
+	rungAccepted = (double*)safeMalloc(sizeof(double)*replicasN);
+	exchTried	 = (double*)safeMalloc(sizeof(double)*replicasN);
+	exchAccepted = (double*)safeMalloc(sizeof(double)*replicasN);
+	winTried	 = (double*)safeMalloc(sizeof(double)*replicasN);
+	winAccepted	 = (double*)safeMalloc(sizeof(double)*replicasN);
+
+	/* geometric ladder; replica i starts at rung i from the same placement, on its own	*/
+	/* random stream (stream 1 is for the exchanges)										*/
+	for(rungi=0;rungi<replicasN;rungi++) {
+		rungTemp[rungi]		= initTemp*pow(freezingTemp/initTemp,(double)rungi/(replicasN-1));
+		rungRlim[rungi]		= (gRangeLimit>0) ? MIN(gRangeLimit,rlimMax) : rlimMax;
+		rungMoves[rungi]	= rungAccepted[rungi] = 0;
+		exchTried[rungi]	= exchAccepted[rungi] = 0;
+		winTried[rungi]		= winAccepted[rungi]  = 0;
+		jobs[rungi].ctl			= &ctl;
+		jobs[rungi].fp			= (rungi==0) ? fp : fpClone(fp);
+		jobs[rungi].stream		= rungi+2;
+		jobs[rungi].rung		= rungi;
+		setRandSeed(gSeed,jobs[rungi].stream);
+		getRandState(&jobs[rungi].rand);
+		jobs[rungi].acceptTable	= arrAlloc(ACCEPT_TABLE_SIZE);
+		jobs[rungi].bestOrder	= arrAlloc(sitesN);
+		jobs[rungi].bestCost	= fp->bbox;
+		arrCopy(fp->cellsOrder,jobs[rungi].bestOrder,sitesN);
+		rungJobs[rungi]			= &jobs[rungi];
+	}
+	bestCost = fp->bbox;
+
+	if (!fp->quiet) {
+		gLogCurTemp	= log(initTemp)/log(10);
+		gInitCost	= fp->bbox;
+		gCurCost	= gInitCost;
+	}
+
+	if (verbose) {
+		printf("Performing parallel tempering with the following parameters:\n");
+		printf("\tReplicas              : %u on %u threads\n",replicasN,threadsN);
+		printf("\tLadder Temperatures   : %e .. %e (geometric, adaptive)\n",initTemp,freezingTemp);
+		printf("\tMoves per Exchange    : %u per replica\n",sweepMoves);
+		printf("\tExchange Rounds       : %u\n",roundsN);
+		printf("\tRange Limit           : %u\n",(unsigned int)rungRlim[0]);
+		printf("\tTarget Acceptance     : %f\n",gAcceptTarget);
+		printf("\tNo Improvement Exit   : %u\n",gNoImprove);
+		printf("\tShift Moves           : %f\n",(fp->cellsN<sitesN) ? MIN(MAX(gShiftProb,0),1) : 0);
+		printf("\tDirected Moves        : up to %f\n",MIN(MAX(gDirectedProb,0),1));
+		printf("\tGreedy Quench         : %s\n",gQuench ? "on" : "off");
+		if (gTimeBudget>0)
+			 printf("\tTime Budget           : %.2fs\n\n",gTimeBudget);
+		else printf("\tTime Budget           : none\n\n");
+	}
+
+	if (gui) {
+		/* update global message and wait for 'Proceed' to proceed */
+		sprintf(gFooterLabel,"Initial floorplan. Press 'Proceed' to continue.");
+		sprintf(gHeaderLabel,"Parallel tempering  Replicas:%u  Temperatures:%.1e..%.1e  MovesPerExchange:%u",
+					replicasN, initTemp, freezingTemp, sweepMoves);
+		waitLoop();
+		if (gPostScript) postscript(drawScreen);
+	}
+
+	/* thread 0 is the calling thread, which also runs the exchanges */
+	ctl.stop	 = 0;
+	ctl.jobs	 = jobs;
+	ctl.jobsN	 = replicasN;
+	ctl.threadsN = threadsN;
+	pthread_barrier_init(&ctl.start,NULL,threadsN);
+	pthread_barrier_init(&ctl.done ,NULL,threadsN);
+	for(threadi=1;threadi<threadsN;threadi++)
+		if (pthread_create(&threads[threadi],NULL,fpTemperThread,&jobs[threadi]) != 0) {
+			printf("-E- Failed creating replica thread %u! Exiting...\n",threadi);
+			exit(-1);
+		}
+	setRandSeed(gSeed,1);
+
+	cpuStart  = fpThreadTime();
+	wallStart = fpWallTime();
+	for(roundi=0;roundi<roundsN;roundi++) {
+
+		/* rung settings of the replicas; directed moves grow with log(temperature) */
+		for(rungi=0;rungi<replicasN;rungi++) {
+			rungJobs[rungi]->temp	= rungTemp[rungi];
+			rungJobs[rungi]->rlim	= (unsigned int)rungRlim[rungi];
+			rungJobs[rungi]->moves	= sweepMoves;
+			rungJobs[rungi]->directedProb = (initTemp>freezingTemp) ?
+				gDirectedProb*log(initTemp/rungTemp[rungi])/log(initTemp/freezingTemp) : 0;
+		}
+		pthread_barrier_wait(&ctl.start);
+		fpTemperSweeps(&jobs[0]);
+		pthread_barrier_wait(&ctl.done);
+
+		/* per-rung acceptance; range limiter (VPR) of each rung */
+		for(rungi=0;rungi<replicasN;rungi++) {
+			rungMoves[rungi]	+= sweepMoves;
+			rungAccepted[rungi]	+= rungJobs[rungi]->accepted;
+			if (gAcceptTarget>0) {
+				rungRlim[rungi] *= 1-gAcceptTarget+(double)(rungJobs[rungi]->accepted)/sweepMoves;
+				rungRlim[rungi]  = MAX(1,MIN(rungRlim[rungi],rlimMax));
+			}
+		}
+
+		/* exchange neighbour rungs, even pairs then odd pairs on alternate rounds */
+		for(rungi=roundi%2;rungi+1<replicasN;rungi+=2) {
+			dBetaCost = (1/rungTemp[rungi]-1/rungTemp[rungi+1])*
+						((double)(rungJobs[rungi]->fp->bbox)-(double)(rungJobs[rungi+1]->fp->bbox));
+			exchTried[rungi]++;
+			winTried[rungi]++;
+			if ((dBetaCost >= 0) || (getFloatRand(0,1) < exp(dBetaCost))) {
+				exchAccepted[rungi]++;
+				winAccepted[rungi]++;
+				tmpJob				= rungJobs[rungi];
+				rungJobs[rungi]		= rungJobs[rungi+1];
+				rungJobs[rungi+1]	= tmpJob;
+				rungJobs[rungi  ]->rung = rungi;
+				rungJobs[rungi+1]->rung = rungi+1;
+			}
+		}
+
+		/* adapt the ladder: scale each log-temperature gap by its exchange ratio over	*/
+		/* the mean one, from the coldest rung up, then stretch it back to its ends		*/
+		if (((roundi+1)%TEMPER_ADAPT == 0)&&(initTemp>freezingTemp)) {
+			exchMean = 0;
+			for(rungi=0;rungi+1<replicasN;rungi++)
+				exchMean += winAccepted[rungi]/MAX(winTried[rungi],1);
+			exchMean /= replicasN-1;
+			gapsSum	  = 0;
+			for(rungi=replicasN-1;rungi>0;rungi--) {
+				gap = log(rungTemp[rungi-1]/rungTemp[rungi])*MIN(2,MAX(0.5,
+					  (winAccepted[rungi-1]/MAX(winTried[rungi-1],1)+0.01)/(exchMean+0.01)));
+				rungTemp[rungi-1]	 = rungTemp[rungi]*exp(gap);
+				gapsSum				+= gap;
+				winTried[rungi-1]	 = winAccepted[rungi-1] = 0;
+			}
+			for(rungi=0;rungi+1<replicasN;rungi++)
+				rungTemp[rungi] = freezingTemp*exp(log(initTemp/freezingTemp)*
+								  log(rungTemp[rungi]/freezingTemp)/gapsSum);
+		}
+
+		/* best of all replicas */
+		for(rungi=0;rungi<replicasN;rungi++)
+			if (jobs[rungi].bestCost < jobs[besti].bestCost) besti = rungi;
+		if (jobs[besti].bestCost < bestCost) {
+			bestCost	 = jobs[besti].bestCost;
+			noImproveCnt = 0;
+		} else noImproveCnt++;
+
+		if (!fp->quiet) {
+			gCurCost	= bestCost;
+			gLogCurTemp	= log(jobs[0].temp)/log(10);
+		}
+		if (refreshCnt == gRefreshRate-1) {
+			if (verbose) printf("- Exchange round: %u, Best cost: %u, Coldest replica cost: %u\n",
+								roundi+1,bestCost,rungJobs[replicasN-1]->fp->bbox);
+			if (gui) {
+				/* update global message and wait for 'Proceed' to proceed */
+				sprintf(gFooterLabel,"Exchange round: %u, Replica 0 temperature: %e, Cost: %u",
+						roundi+1,jobs[0].temp,fp->bbox);
+				waitLoop();
+				if (gPostScript) postscript(drawScreen);
+			}
+			refreshCnt = 0;
+		} else refreshCnt++;
+
+		if ((gNoImprove>0)&&(noImproveCnt>=gNoImprove)) {
+			if (verbose) printf("- No improvement for %u exchange rounds, stopping\n",noImproveCnt);
+			roundi++;
+			break;
+		}
+		if ((gTimeBudget>0)&&(fpWallTime()-wallStart>=gTimeBudget)) {
+			if (verbose) printf("- Time budget exhausted at exchange round %u\n",roundi+1);
+			roundi++;
+			break;
+		}
+
+		/* fit the remaining exchange rounds into the time budget, at least the work of	*/
+		/* cells# moves per thread														*/
+		if ((gTimeBudget>0)&&(roundi+1<roundsN)) {
+			elapsed	   = fpWallTime()-wallStart;
+			sweepMoves = (unsigned int)MIN(UINT_MAX,MAX(MAX(1,(double)(fp->cellsN)*threadsN/replicasN),
+							rungMoves[0]/MAX(elapsed,1e-6)*(gTimeBudget-elapsed)/(roundsN-roundi-1)));
+		}
+	}
+	ctl.stop = 1;
+	pthread_barrier_wait(&ctl.start);
+	for(threadi=1;threadi<threadsN;threadi++)
+		pthread_join(threads[threadi],NULL);
+	pthread_barrier_destroy(&ctl.start);
+	pthread_barrier_destroy(&ctl.done );
+
+	/* keep the best placement of all replicas */
+	arrCopy(jobs[besti].bestOrder,fp->cellsOrder,sitesN);
+	cpuTime = fpAnnealFinish(fp,QUENCH_MIN_RLIM,cpuStart,wallStart);
+
+	if (verbose) {
+		printf("- Exchange rounds: %u, best replica: %u\n", roundi, besti);
+		printf("- Moves per replica: %.0f, CPU time of replica 0: %.2fs\n", rungMoves[0], cpuTime);
+		for(rungi=0;rungi<replicasN;rungi++) {
+			printf("- Rung %u: temperature %e, acceptance %.3f",rungi,rungTemp[rungi],
+					(rungMoves[rungi]>0) ? rungAccepted[rungi]/rungMoves[rungi] : 0);
+			if (rungi+1<replicasN)
+				 printf(", exchange with next %.3f\n",(exchTried[rungi]>0) ? exchAccepted[rungi]/exchTried[rungi] : 0);
+			else printf("\n");
+		}
+	}
+
+	for(rungi=0;rungi<replicasN;rungi++) {
+		safeFree(jobs[rungi].acceptTable);
+		safeFree(jobs[rungi].bestOrder);
+		if (rungi>0) fpDelete(jobs[rungi].fp);
+	}
+	safeFree(jobs);
+	safeFree(rungJobs);
+	safeFree(threads);
+	safeFree(rungTemp);
+	safeFree(rungRlim);
+	safeFree(rungMoves);
+	safeFree(rungAccepted);
+	safeFree(exchTried);
+	safeFree(exchAccepted);
+	safeFree(winTried);
+	safeFree(winAccepted);
+
+} /* fpTemper */
+
+/* region-partitioned annealing step of a thread: copy the merged placement, list the	*/
+/* cells of the rows region as first cells of moves, and sweep inside the region		*/
+static void fpRegionStep(fpSweepJob *job) {
+
+	floorplan	*fp		= job->fp;
+	floorplan	*master = job->ctl->master;
+	unsigned int sitesN = (fp->nx)*(fp->ny);
+	unsigned int celli;
+
+	arrCopy(master->cellsOrder,fp->cellsOrder,sitesN);
+	arrCopy(master->cellsX	  ,fp->cellsX	 ,sitesN);
+	arrCopy(master->cellsY	  ,fp->cellsY	 ,sitesN);
+	arrCopy(master->siteCells ,fp->siteCells ,sitesN);
+	memcpy(fp->nets,master->nets,sizeof(net)*(fp->netsN));
+	fp->bbox = master->bbox;
+
+	fp->moveCellsN = 0;
+	for(celli=0;celli<fp->cellsN;celli++)
+		if ((fp->cellsY[celli]>=fp->rowLo)&&(fp->cellsY[celli]<=fp->rowHi))
+			fp->moveCells[(fp->moveCellsN)++] = celli;
+
+	if (fp->moveCellsN > 0)
+		 fpSweep(job);
+	else job->accepted = 0; /* an empty region */
+
+} /* fpRegionStep */
+
+/* region-partitioned annealing thread: a region step whenever the merge releases it	*/
+static void *fpRegionThread(void *arg) {
+
+	fpSweepJob *job = (fpSweepJob*)arg;
+
+	setRandSeed(gSeed,job->stream);
+	while (1) {
+		pthread_barrier_wait(&job->ctl->start);
+		if (job->ctl->stop) break;
+		fpRegionStep(job);
+		pthread_barrier_wait(&job->ctl->done);
+	}
+	return NULL;
+
+} /* fpRegionThread */
+
+/* region-partitioned annealing: one cooling chain, with the moves of every temperature	*/
+/* split among 'threadsN' threads. Each thread owns a stripe of rows and moves cells	*/
+/* only between sites of its stripe, on a private copy of the placement. Nets crossing	*/
+/* stripes are evaluated with the other stripes at their positions when the temperature	*/
+/* started; after the temperature the stripes are merged and all nets are recomputed	*/
+/* exactly. The stripe boundaries shift by a random offset every temperature, so cells	*/
+/* can migrate. The best placement is kept in fp										*/
+void fpAnnealRegions(floorplan *fp, unsigned int threadsN, unsigned int movesPerTemp, double initTemp,
+					 double coolingRate, double freezingTemp								) {
+
+	fpSchedule	 sch;
+	fpSweepCtl	 ctl;
+	fpSweepJob	*jobs;
+	pthread_t	*threads;
+	unsigned int *rowsLo, *rowsHi;	/* rows region of each thread		*/
+	unsigned int *bestOrder;
+	unsigned int sitesN	 = (fp->nx)*(fp->ny);
+	unsigned int stripe, offset, threadi, sitei, moveType;
+	unsigned int acceptCnt, startCost;
+	double		 driftSum = 0, estimated;
+	double		 proposed[MOVE_TYPES], accepted[MOVE_TYPES];
+	double		 cpuTime;
+	char		 label[32];
+
+	fpScheduleInit(fp,&sch,movesPerTemp,initTemp,coolingRate,freezingTemp);
+
+	if (threadsN < 2) threadsN = REGION_THREADS;
+	threadsN = MIN(threadsN,(fp->ny)/REGION_MIN_ROWS);
+	if (threadsN < 2) { /* too few rows for two stripes */
+		if (sch.verbose) printf("- %u rows are too few for region-partitioned annealing, annealing serially\n",fp->ny);
+		fpAnneal(fp,movesPerTemp,initTemp,coolingRate,freezingTemp);
+		return;
+	}
+	stripe = (fp->ny)/threadsN;
+
+	jobs	  = (fpSweepJob*)safeMalloc(sizeof(fpSweepJob)*threadsN);
+	threads	  = (pthread_t*)safeMalloc(sizeof(pthread_t)*threadsN);
+	rowsLo	  = arrAlloc(threadsN);
+	rowsHi	  = arrAlloc(threadsN);
+	bestOrder = arrAlloc(sitesN);
+	arrCopy(fp->cellsOrder,bestOrder,sitesN);
+	for(threadi=0;threadi<threadsN;threadi++) {
+		jobs[threadi].ctl			= &ctl;
+		jobs[threadi].fp			= fpClone(fp);
+		jobs[threadi].fp->moveCells	= arrAlloc(MAX(fp->cellsN,1));
+		jobs[threadi].stream		= threadi+1;
+		jobs[threadi].acceptTable	= arrAlloc(ACCEPT_TABLE_SIZE);
+		jobs[threadi].bestOrder		= NULL; /* a stripe alone has no meaningful best */
+	}
+
+	if (sch.verbose) {
+		printf("Performing region-partitioned annealing with the following parameters:\n");
+		printf("\tThreads               : %u (row stripes of %u rows, %u moves each)\n",threadsN,stripe,
+				MAX(1,(movesPerTemp+threadsN-1)/threadsN));
+	}
+	sprintf(label,"Regions:%u  ",threadsN);
+	fpScheduleStart(fp,&sch,label,0);
+
+	/* thread 0 is the calling thread, which also merges the stripes */
+	ctl.stop   = 0;
+	ctl.master = fp;
+	pthread_barrier_init(&ctl.start,NULL,threadsN);
+	pthread_barrier_init(&ctl.done ,NULL,threadsN);
+	for(threadi=1;threadi<threadsN;threadi++)
+		if (pthread_create(&threads[threadi],NULL,fpRegionThread,&jobs[threadi]) != 0) {
+			printf("-E- Failed creating region thread %u! Exiting...\n",threadi);
+			exit(-1);
+		}
+	setRandSeed(gSeed,1);
+
+	while(sch.curTemp>sch.freezingTemp) {
+
+		fpScheduleRefresh(fp,&sch);
+
+		/* stripes, shifted by a random offset; the last one keeps at least two rows */
+		offset = getUIntRand(0,stripe-2);
+		for(threadi=0;threadi<threadsN;threadi++) {
+			rowsLo[threadi] = (threadi==0)			? 0			: threadi*stripe+offset;
+			rowsHi[threadi] = (threadi==threadsN-1) ? (fp->ny)-1	: (threadi+1)*stripe+offset-1;
+			jobs[threadi].fp->rowLo		= rowsLo[threadi];
+			jobs[threadi].fp->rowHi		= rowsHi[threadi];
+			jobs[threadi].temp			= sch.curTemp;
+			jobs[threadi].rlim			= (unsigned int)sch.rlim;
+			jobs[threadi].moves			= MAX(1,(sch.movesPerTemp+threadsN-1)/threadsN);
+			jobs[threadi].directedProb	= fpScheduleDirected(&sch);
+		}
+		startCost = fp->bbox;
+		pthread_barrier_wait(&ctl.start);
+		fpRegionStep(&jobs[0]);
+		pthread_barrier_wait(&ctl.done);
+
+		/* merge: every stripe takes its sites from its thread, then exact net costs */
+		acceptCnt = 0;
+		estimated = startCost;
+		for(threadi=0;threadi<threadsN;threadi++) {
+			for(sitei=rowsLo[threadi]*(fp->nx);sitei<(rowsHi[threadi]+1)*(fp->nx);sitei++)
+				fp->cellsOrder[jobs[threadi].fp->siteCells[sitei]] = sitei;
+			acceptCnt += jobs[threadi].accepted;
+			estimated += (double)(jobs[threadi].fp->bbox)-startCost;
+		}
+		fpCellsUpdateLoc(fp);
+		fpAllNetsUpdateBBox(fp);
+		driftSum += fabs(estimated-fp->bbox);
+
+		if (fp->bbox < sch.bestCost) {
+			sch.bestCost = fp->bbox;
+			arrCopy(fp->cellsOrder,bestOrder,sitesN);
+		}
+
+		if (fpScheduleStep(fp,&sch,acceptCnt,jobs[0].moves*threadsN)) break;
+	}
+	ctl.stop = 1;
+	pthread_barrier_wait(&ctl.start);
+	for(threadi=1;threadi<threadsN;threadi++)
+		pthread_join(threads[threadi],NULL);
+	pthread_barrier_destroy(&ctl.start);
+	pthread_barrier_destroy(&ctl.done );
+
+	/* restore best placement */
+	arrCopy(bestOrder,fp->cellsOrder,sitesN);
+	cpuTime = fpAnnealFinish(fp,(unsigned int)sch.rlim,sch.cpuStart,sch.wallStart);
+
+	if (sch.verbose) {
+		for(moveType=0;moveType<MOVE_TYPES;moveType++) {
+			proposed[moveType] = accepted[moveType] = 0;
+			for(threadi=0;threadi<threadsN;threadi++) {
+				proposed[moveType] += jobs[threadi].fp->moveProposed[moveType];
+				accepted[moveType] += jobs[threadi].fp->moveAccepted[moveType];
+			}
+		}
+		printf("- Moves: %.0f, CPU time of thread 0: %.2fs\n", sch.movesCnt, cpuTime);
+		printf("- Temperatures: %u, average merge drift (estimated vs. exact cost): %.1f\n",
+					sch.tempsCnt, (sch.tempsCnt>0) ? driftSum/sch.tempsCnt : 0);
+		for(moveType=0;moveType<MOVE_TYPES;moveType++)
+			printf("- %s moves: proposed %.0f, accepted %.0f (%.3f)\n",fpMoveNames[moveType],
+					proposed[moveType],accepted[moveType],
+					(proposed[moveType]>0) ? accepted[moveType]/proposed[moveType] : 0);
+	}
+
+	for(threadi=0;threadi<threadsN;threadi++) {
+		safeFree(jobs[threadi].acceptTable);
+		fpDelete(jobs[threadi].fp);
+	}
+	safeFree(jobs);
+	safeFree(threads);
+	safeFree(rowsLo);
+	safeFree(rowsHi);
 	safeFree(bestOrder);
 
-} /* fpAnneal */
+} /* fpAnnealRegions */
+
+/* speculative annealing thread job: a batch of candidate moves, proposed, evaluated,	*/
+/* and accepted or rejected against the shared placement through a private view			*/
+typedef struct {
+	fpSweepCtl	*ctl;
+	floorplan	*fp;			/* view: shared placement, private scratch	*/
+	unsigned int stream;		/* random stream of the thread				*/
+	unsigned int rlim;			/* range limit								*/
+	double		 temp;			/* temperature								*/
+	unsigned int *acceptTable;	/* uphill thresholds at temp				*/
+	unsigned int batchN;		/* candidate moves per batch				*/
+	unsigned int *cell1, *cell2;/* candidate moves							*/
+	unsigned int *type;			/* move type of each candidate				*/
+	int			 *gain;			/* cost gain (old-new) of each candidate	*/
+	int			 *accepted;		/* Metropolis decision of each candidate	*/
+	unsigned int *trialInd;		/* first stored trial net of each candidate	*/
+	unsigned int *trialNets;	/* nets touched by the accepted candidates	*/
+	box			 *trialBox;		/* trial bounding boxes of those nets		*/
+} fpSpecJob;
+
+/* speculative annealing view: a quiet floorplan sharing the placement of 'fp', with a	*/
+/* private trial scratch so threads can evaluate moves concurrently; never commit on it	*/
+static floorplan *fpSpecView(floorplan *fp) {
+
+	floorplan *view = fpClone(fp);
+
+	safeFree(view->cellsOrder); view->cellsOrder = fp->cellsOrder;
+	safeFree(view->cellsX	 ); view->cellsX	 = fp->cellsX	 ;
+	safeFree(view->cellsY	 ); view->cellsY	 = fp->cellsY	 ;
+	safeFree(view->siteCells ); view->siteCells	 = fp->siteCells ;
+	safeFree(view->nets		 ); view->nets		 = fp->nets		 ;
+	view->view = 1;
+	return view;
+
+} /* fpSpecView */
+
+/* speculative annealing batch: propose, evaluate, and decide a batch of moves on the	*/
+/* view; nothing is committed, the trials of accepted moves are kept for the commit		*/
+static void fpSpecBatch(fpSpecJob *job) {
+
+	floorplan	*view = job->fp;
+	unsigned int candi;
+
+	job->trialInd[0] = 0;
+	for(candi=0;candi<job->batchN;candi++) {
+		job->type[candi]	 = fpProposeMove(view,job->rlim,&job->cell1[candi],&job->cell2[candi]);
+		job->gain[candi]	 = -fpEvaluateSwap(view,job->cell1[candi],job->cell2[candi]);
+		job->accepted[candi] = fpMetropolis(job->gain[candi],job->temp,job->acceptTable);
+
+		/* keep the trial of an accepted candidate for the commit phase */
+		job->trialInd[candi+1] = job->trialInd[candi];
+		if (!job->accepted[candi]) continue;
+		memcpy(job->trialNets+job->trialInd[candi],view->trialNets,sizeof(unsigned int)*(view->trialN));
+		memcpy(job->trialBox +job->trialInd[candi],view->trialBox ,sizeof(box)*(view->trialN));
+		job->trialInd[candi+1] += view->trialN;
+	}
+
+} /* fpSpecBatch */
+
+/* speculative annealing thread: evaluate a batch whenever the commit phase releases it	*/
+static void *fpSpecThread(void *arg) {
+
+	fpSpecJob *job = (fpSpecJob*)arg;
+
+	setRandSeed(gSeed,job->stream);
+	while (1) {
+		pthread_barrier_wait(&job->ctl->start);
+		if (job->ctl->stop) break;
+		fpSpecBatch(job);
+		pthread_barrier_wait(&job->ctl->done);
+	}
+	return NULL;
+
+} /* fpSpecThread */
+
+/* speculative annealing conflict: the cell (or void) or one of its nets was changed by	*/
+/* a move committed in the current batch, marked with 'stamp'							*/
+static int fpSpecConflict(floorplan *fp, unsigned int cellId,
+						  unsigned int *cellMark, unsigned int *netMark, unsigned int stamp) {
+
+	unsigned int pini;
+
+	if (cellMark[cellId] == stamp) return 1;
+	if (cellId >= fp->cellsN) return 0; /* a void has no nets */
+	for(pini=fp->cellNetsInd[cellId]; pini<fp->cellNetsInd[cellId+1]; pini++)
+		if (netMark[fp->cellNets[pini]] == stamp) return 1;
+	return 0;
+
+} /* fpSpecConflict */
+
+/* speculative annealing commit of a candidate accepted on a view, with the trial kept	*/
+/* by fpSpecBatch; exact while none of its cells, sites, or nets changed in the batch	*/
+static void fpSpecCommit(floorplan *fp, fpSpecJob *job, unsigned int candi) {
+
+	unsigned int first = job->trialInd[candi];
+
+	fp->trialCell1 = job->cell1[candi];
+	fp->trialCell2 = job->cell2[candi];
+	fp->trialDelta = -job->gain[candi];
+	fp->trialN	   = job->trialInd[candi+1]-first;
+	memcpy(fp->trialNets,job->trialNets+first,sizeof(unsigned int)*(fp->trialN));
+	memcpy(fp->trialBox ,job->trialBox +first,sizeof(box)*(fp->trialN));
+	fpCommitSwap(fp);
+
+} /* fpSpecCommit */
+
+/* speculative annealing: one cooling chain on the shared placement. Per batch, every	*/
+/* thread proposes and evaluates SPEC_BATCH moves against the placement; a serial		*/
+/* commit phase then takes the candidates in order; any candidate sharing a cell, site,	*/
+/* or net with a move committed earlier in the batch is rejected and replaced by a		*/
+/* new move proposed and decided on the current placement (a stale candidate is not		*/
+/* one the serial generator would draw there). The others commit the trial of their		*/
+/* thread. Each decision is made on an exact cost, so the chain is a sequential one		*/
+void fpAnnealSpeculative(floorplan *fp, unsigned int threadsN, unsigned int movesPerTemp,
+						 double initTemp, double coolingRate, double freezingTemp			) {
+
+	fpSchedule	 sch;
+	fpSweepCtl	 ctl;
+	fpSpecJob	*jobs;
+	pthread_t	*threads;
+	unsigned int *cellMark, *netMark; /* batch stamp of committed cells/sites, nets	*/
+	unsigned int *bestOrder;		/* best snapshot, if bestSaved				*/
+	unsigned int *journal;			/* swaps since best placement				*/
+	unsigned int  journalN = 0;
+	int			  bestSaved = 0;
+	unsigned int sitesN	 = (fp->nx)*(fp->ny);
+	unsigned int threadi, candi, triali, moveType, cellId1, cellId2, imove, batchStamp = 0;
+	unsigned int batchN;			/* candidate moves per thread and batch		*/
+	unsigned int acceptCnt, commitsN, trialMax = 0;
+	int			 gain, conflict;
+	double		 conflictsCnt = 0, commitsCnt = 0;
+	double		 proposed[MOVE_TYPES], acceptedCnt[MOVE_TYPES];
+	double		 cpuTime;
+	char		 label[32];
+
+	fpScheduleInit(fp,&sch,movesPerTemp,initTemp,coolingRate,freezingTemp);
+
+	if (threadsN < 2) threadsN = SPEC_THREADS;
+
+	jobs	  = (fpSpecJob*)safeMalloc(sizeof(fpSpecJob)*threadsN);
+	threads	  = (pthread_t*)safeMalloc(sizeof(pthread_t)*threadsN);
+	cellMark  = arrAlloc(sitesN);
+	netMark	  = arrAlloc(MAX(fp->netsN,1));
+	bestOrder = arrAlloc(sitesN);
+	journal	  = arrAlloc(2*sitesN);
+	arrInit(cellMark,0,sitesN);
+	arrInit(netMark ,0,MAX(fp->netsN,1));
+	for(moveType=0;moveType<MOVE_TYPES;moveType++)
+		acceptedCnt[moveType] = 0;
+	for(candi=0;candi<fp->cellsN;candi++) /* nets touched by a swap, at most */
+		trialMax = MAX(trialMax,fp->cellNetsInd[candi+1]-fp->cellNetsInd[candi]);
+	trialMax = MAX(1,MIN(fp->netsN,2*trialMax));
+	for(threadi=0;threadi<threadsN;threadi++) {
+		jobs[threadi].ctl		  = &ctl;
+		jobs[threadi].fp		  = fpSpecView(fp);
+		jobs[threadi].stream	  = threadi+1;
+		jobs[threadi].acceptTable = arrAlloc(ACCEPT_TABLE_SIZE);
+		jobs[threadi].cell1		  = arrAlloc(SPEC_BATCH);
+		jobs[threadi].cell2		  = arrAlloc(SPEC_BATCH);
+		jobs[threadi].type		  = arrAlloc(SPEC_BATCH);
+		jobs[threadi].gain		  = (int*)safeMalloc(sizeof(int)*SPEC_BATCH);
+		jobs[threadi].accepted	  = (int*)safeMalloc(sizeof(int)*SPEC_BATCH);
+		jobs[threadi].trialInd	  = arrAlloc(SPEC_BATCH+1);
+		jobs[threadi].trialNets	  = arrAlloc(SPEC_BATCH*trialMax);
+		jobs[threadi].trialBox	  = (box*)safeMalloc(sizeof(box)*SPEC_BATCH*trialMax);
+	}
+
+	if (sch.verbose) {
+		printf("Performing speculative annealing with the following parameters:\n");
+		printf("\tThreads               : %u (batches of up to %u moves each)\n",threadsN,SPEC_BATCH);
+	}
+	sprintf(label,"Speculative:%u  ",threadsN);
+	fpScheduleStart(fp,&sch,label,0);
+
+	/* thread 0 is the calling thread, which also runs the commit phase */
+	ctl.stop   = 0;
+	ctl.master = fp;
+	pthread_barrier_init(&ctl.start,NULL,threadsN);
+	pthread_barrier_init(&ctl.done ,NULL,threadsN);
+	for(threadi=1;threadi<threadsN;threadi++)
+		if (pthread_create(&threads[threadi],NULL,fpSpecThread,&jobs[threadi]) != 0) {
+			printf("-E- Failed creating speculative thread %u! Exiting...\n",threadi);
+			exit(-1);
+		}
+	setRandSeed(gSeed,1);
+
+	while(sch.curTemp>sch.freezingTemp) {
+
+		fpScheduleRefresh(fp,&sch);
+
+		/* move types mix, acceptance thresholds, and batch size of the temperature */
+		batchN = (unsigned int)MIN(SPEC_BATCH,MAX(1,SPEC_COMMITS/(threadsN*MAX(sch.acceptRate,1e-6))));
+		for(threadi=0;threadi<threadsN;threadi++) {
+			jobs[threadi].batchN = batchN;
+			fpMoveMix(jobs[threadi].fp,fpScheduleDirected(&sch));
+			fpAcceptTable(jobs[threadi].acceptTable,sch.curTemp);
+			jobs[threadi].temp = sch.curTemp;
+			jobs[threadi].rlim = (unsigned int)sch.rlim;
+		}
+		fpMoveMix(fp,jobs[0].fp->moveProb[MOVE_DIRECTED]); /* serial and re-proposed moves */
+
+		acceptCnt = 0;
+
+		/* hot temperature: serial moves on the calling thread */
+		if (sch.acceptRate > SPEC_MAX_ACCEPT) {
+			for(imove=0;imove<sch.movesPerTemp;imove++) {
+				moveType = fpProposeMove(fp,(unsigned int)sch.rlim,&cellId1,&cellId2);
+				gain	 = -fpEvaluateSwap(fp,cellId1,cellId2);
+				if (!fpMetropolis(gain,sch.curTemp,jobs[0].acceptTable)) continue;
+				fpCommitSwap(fp);
+				acceptedCnt[moveType]++;
+				acceptCnt++;
+				commitsCnt++;
+				if (fp->bbox < sch.bestCost) { /* new best, O(1) */
+					journalN	 = 0;
+					bestSaved	 = 0;
+					sch.bestCost = fp->bbox;
+				} else fpJournalPush(fp,cellId1,cellId2,journal,&journalN,bestOrder,&bestSaved);
+			}
+		}
+
+		for(imove=(sch.acceptRate > SPEC_MAX_ACCEPT) ? sch.movesPerTemp : 0;imove<sch.movesPerTemp;imove+=threadsN*batchN) {
+			pthread_barrier_wait(&ctl.start);
+			fpSpecBatch(&jobs[0]);
+			pthread_barrier_wait(&ctl.done);
+
+			/* commit phase, candidates in thread then batch order */
+			commitsN  = 0;
+			batchStamp++;
+			for(threadi=0;threadi<threadsN;threadi++)
+				for(candi=0;candi<batchN;candi++) {
+					cellId1	 = jobs[threadi].cell1[candi];
+					cellId2	 = jobs[threadi].cell2[candi];
+
+					/* conflict: a cell, site, or net changed earlier in this batch */
+					conflict = (commitsN > 0) &&
+							   (fpSpecConflict(fp,cellId1,cellMark,netMark,batchStamp) ||
+								fpSpecConflict(fp,cellId2,cellMark,netMark,batchStamp));
+					moveType = jobs[threadi].type[candi];
+					if (conflict) { /* rejected, re-proposed on the current placement */
+						conflictsCnt++;
+						moveType = fpProposeMove(fp,(unsigned int)sch.rlim,&cellId1,&cellId2);
+						gain	 = -fpEvaluateSwap(fp,cellId1,cellId2);
+						if (!fpMetropolis(gain,sch.curTemp,jobs[0].acceptTable)) continue;
+						fpCommitSwap(fp);
+					} else if (jobs[threadi].accepted[candi])
+						fpSpecCommit(fp,&jobs[threadi],candi);
+					else continue;
+
+					acceptedCnt[moveType]++;
+					acceptCnt++;
+					commitsN++;
+					cellMark[cellId1] = cellMark[cellId2] = batchStamp;
+					for(triali=0;triali<fp->trialN;triali++)
+						netMark[fp->trialNets[triali]] = batchStamp;
+					if (fp->bbox < sch.bestCost) { /* new best, O(1) */
+						journalN	 = 0;
+						bestSaved	 = 0;
+						sch.bestCost = fp->bbox;
+					} else fpJournalPush(fp,cellId1,cellId2,journal,&journalN,bestOrder,&bestSaved);
+				}
+			commitsCnt += commitsN;
+		}
+
+		if (fpScheduleStep(fp,&sch,acceptCnt,imove)) break;
+	}
+	ctl.stop = 1;
+	pthread_barrier_wait(&ctl.start);
+	for(threadi=1;threadi<threadsN;threadi++)
+		pthread_join(threads[threadi],NULL);
+	pthread_barrier_destroy(&ctl.start);
+	pthread_barrier_destroy(&ctl.done );
+
+	/* restore best placement */
+	if (bestSaved)
+		 arrCopy(bestOrder,fp->cellsOrder,sitesN);
+	else fpJournalUndo(fp->cellsOrder,journal,journalN);
+	cpuTime = fpAnnealFinish(fp,(unsigned int)sch.rlim,sch.cpuStart,sch.wallStart);
+
+	if (sch.verbose) {
+		for(moveType=0;moveType<MOVE_TYPES;moveType++) {
+			proposed[moveType] = fp->moveProposed[moveType]; /* serial moves */
+			for(threadi=0;threadi<threadsN;threadi++)
+				proposed[moveType] += jobs[threadi].fp->moveProposed[moveType];
+		}
+		printf("- Moves: %.0f, CPU time of thread 0: %.2fs\n", sch.movesCnt, cpuTime);
+		printf("- Temperatures: %u, committed moves: %.0f, conflicts re-proposed: %.0f (%.4f of moves)\n",
+					sch.tempsCnt, commitsCnt, conflictsCnt, (sch.movesCnt>0) ? conflictsCnt/sch.movesCnt : 0);
+		for(moveType=0;moveType<MOVE_TYPES;moveType++)
+			printf("- %s moves: proposed %.0f, accepted %.0f (%.3f)\n",fpMoveNames[moveType],
+					proposed[moveType],acceptedCnt[moveType],
+					(proposed[moveType]>0) ? acceptedCnt[moveType]/proposed[moveType] : 0);
+	}
+
+	for(threadi=0;threadi<threadsN;threadi++) {
+		safeFree(jobs[threadi].acceptTable);
+		safeFree(jobs[threadi].cell1);
+		safeFree(jobs[threadi].cell2);
+		safeFree(jobs[threadi].type);
+		safeFree(jobs[threadi].gain);
+		safeFree(jobs[threadi].accepted);
+		safeFree(jobs[threadi].trialInd);
+		safeFree(jobs[threadi].trialNets);
+		safeFree(jobs[threadi].trialBox);
+		fpDelete(jobs[threadi].fp);
+	}
+	safeFree(jobs);
+	safeFree(threads);
+	safeFree(cellMark);
+	safeFree(netMark);
+	safeFree(bestOrder);
+	safeFree(journal);
+
+} /* fpAnnealSpeculative */
@@ -36,21 +36,25 @@
 #ifndef __FLOORPLAN_HEADER__
 #define __FLOORPLAN_HEADER__
 
-/* net data structure																	*/
+/* move types of the move generator (see fpProposeMove)									*/
+#define MOVE_SWAP		0	/* swap a cell with the cell or void of a site in range		*/
+#define MOVE_SHIFT		1	/* relocate a cell into an empty site in range				*/
+#define MOVE_DIRECTED	2	/* move a cell into the median region of its nets			*/
+#define MOVE_TYPES		3	/* amount of move types										*/
+
+/* parallel annealing engines (see gParallel)											*/
+#define PARALLEL_NONE		0	/* single cooling chain (or multi-start, see -threads)	*/
+#define PARALLEL_TEMPERING	1	/* replica exchange at a temperature ladder				*/
+#define PARALLEL_REGIONS	2	/* one chain, moves split among row stripes			*/
+#define PARALLEL_SPECULATIVE 3	/* one chain, moves evaluated in parallel batches		*/
+
+/* net data structure, net cells are listed in the floorplan CSR netlist				*/
 struct netStruct {
-	unsigned int  cellsN;	/* the amount of cells connected to this net				*/
-	unsigned int *cells ;	/* a listing of cells id's connected with this net			*/
 	unsigned int  bbox  ;	/* 1/2 perimeter of the smallest bounding box with all pins	*/
+	box           bounds;	/* bounding box edges and pins# on each edge (incremental)	*/
 };
 typedef struct netStruct net;
 
-/* cell data structure																	*/
-struct cellStruct {
-	unsigned int  netsN   ; /* the amount of nets connected to this cell (pins#)		*/
-	unsigned int *nets    ;	/* a listing of the nets connected with this cell			*/
-};
-typedef struct cellStruct cell;
-
 /* floorplan data structure																*/
 struct floorplanStruct {
 	unsigned int  nx		; /* amount of rows in the floorplan						*/
@@ -58,9 +62,42 @@ struct floorplanStruct {
 	unsigned int  cellsN	; /* amount of cells in the floorplan						*/
 	unsigned int  netsN		; /* amount of nets in the floorplan						*/
 	unsigned int  bbox		; /* sum of bbox 1/2 perimeter for all nets in the floorplan*/
-	cell         *cells		; /* a listing of the cells int the floorplan				*/
+	unsigned int  pinsN		; /* amount of pins (net,cell connections) in the floorplan	*/
 	unsigned int *cellsOrder; /* a listing of the cells int the floorplan				*/
+	unsigned int *cellsX	; /* x coordinate (column) of each cell, from cellsOrder	*/
+	unsigned int *cellsY	; /* y coordinate (row) of each cell, from cellsOrder		*/
+	unsigned int *siteCells	; /* inverse of cellsOrder: the cell id placed in each site	*/
 	net          *nets		; /* a listing of the cells int the floorplan				*/
+	unsigned int *netCellsInd;/* CSR offsets: cells of net i are in netCells			*/
+							  /*	   [netCellsInd[i] .. netCellsInd[i+1]-1]			*/
+	unsigned int *netCells	; /* CSR indices: cells connected to each net				*/
+	unsigned int *cellNetsInd;/* CSR offsets: nets of cell i are in cellNets			*/
+							  /*	   [cellNetsInd[i] .. cellNetsInd[i+1]-1]			*/
+	unsigned int *cellNets	; /* CSR indices: nets connected to each cell				*/
+	unsigned int  trialCell1; /* first cell of the last evaluated (trial) swap			*/
+	unsigned int  trialCell2; /* second cell of the last evaluated (trial) swap			*/
+	int           trialDelta; /* cost change of the last evaluated (trial) swap			*/
+	unsigned int  trialN	; /* amount of nets touched by the trial swap				*/
+	unsigned int *trialNets	; /* a listing of the nets touched by the trial swap		*/
+	box          *trialBox	; /* trial bounding box of each net touched by the swap		*/
+	unsigned int *netStamp	; /* per net trial stamp, detects nets shared by both cells	*/
+	unsigned int  stamp		; /* current trial stamp									*/
+	unsigned int *regionX	; /* directed move scratch: x bounds of the cell nets		*/
+	unsigned int *regionY	; /* directed move scratch: y bounds of the cell nets		*/
+	double moveProb[MOVE_TYPES]    ; /* probability of proposing each move type			*/
+	double moveProposed[MOVE_TYPES]; /* amount of proposed moves of each type			*/
+	double moveAccepted[MOVE_TYPES]; /* amount of accepted moves of each type			*/
+	double banditGain[MOVE_TYPES]  ; /* bandit: decayed cost improvement of timed moves */
+	double banditTime[MOVE_TYPES]  ; /* bandit: decayed CPU seconds of timed moves		*/
+	int           clone		; /* shares the netlist of another floorplan (fpClone)		*/
+	int           view		; /* shares the placement of another floorplan too		*/
+	int           quiet		; /* no verbose, GUI, or drawing state updates (threads)	*/
+	int           partial	; /* one of several multi-start annealers, not the result	*/
+	unsigned int  rowLo		; /* moves are limited to the rows region [rowLo,rowHi]		*/
+	unsigned int  rowHi		; /*   (all rows by default)								*/
+	unsigned int *moveCells	; /* first cells of moves, the cells in the rows region		*/
+							  /*   NULL: any cell										*/
+	unsigned int  moveCellsN; /* amount of moveCells									*/
 };
 typedef struct floorplanStruct floorplan;
 
@@ -70,6 +107,17 @@ extern int			gVerbose    	  ; /* verbose status       	  (see annealing.c)	*/
 extern int			gGUI         	  ; /* enable GUI mode      	  (see annealing.c)	*/
 extern int			gPostScript   	  ;	/* enable postscript     	  (see annealing.c)	*/
 extern unsigned int	gRefreshRate	  ; /* refreshRate/tempChange	  (see annealing.c)	*/
+extern unsigned int	gRangeLimit		  ; /* swap window radius, 0: all (see annealing.c)	*/
+extern double		gAcceptTarget	  ; /* range limiter target, 0:off(see annealing.c)	*/
+extern int			gEquilibrium	  ; /* end temperature at equilibrium(see annealing.c)*/
+extern unsigned int	gNoImprove		  ; /* exit after temps w/o new best(see annealing.c)*/
+extern int			gQuench			  ; /* final greedy quench		  (see annealing.c)	*/
+extern double		gTimeBudget		  ; /* wall-clock seconds, 0: none(see annealing.c)	*/
+extern double		gShiftProb		  ; /* shift moves probability	  (see annealing.c)	*/
+extern double		gDirectedProb	  ; /* directed moves final prob. (see annealing.c)	*/
+extern int			gBandit			  ; /* adaptive move types mix	  (see annealing.c)	*/
+extern unsigned long gSeed			  ; /* random seed				  (see annealing.c)	*/
+extern int			gParallel		  ; /* parallel engine			  (see annealing.c)	*/
 extern char			gFooterLabel[1024]; /* global footer text message (see annealing.c)	*/
 extern char			gHeaderLabel[1024]; /* global header text message (see annealing.c)	*/
 extern void			drawScreen()  	  ; /* draw graphics routine	  (see annealing.c)	*/
@@ -82,9 +130,17 @@ floorplan	*fpCreate(const char *fileName											);
 /* free a floorplan data structure														*/
 void		 fpDelete(floorplan  *fp													);
 
+/* returns a new allocated copy of a floorplan with a private placement and scratch,	*/
+/* sharing the read-only netlist of 'fp'; the copy is quiet. Free with fpDelete			*/
+floorplan	*fpClone(floorplan  *fp														);
+
 /* dump a floorplan data structure to stdout - for verification purpose					*/
 void		 fpDump(floorplan  *fp														);
 
+/* update cells x/y coordinates and the site->cell map from the cells order			*/
+/* (after changing cellsOrder)															*/
+void		 fpCellsUpdateLoc(floorplan *fp												);
+
 /* update net's bbox in the floorplan database											*/
 unsigned int fpNetUpdateBBox(floorplan *fp, unsigned int netID							);
 
@@ -103,10 +159,77 @@ void		 fpDraw	(floorplan *fp, float xWorld, float yWorld							);
 /* swap the order of two cells and update the cost										*/
 void		 fpSwapCells(floorplan *pf, unsigned int cellId1, unsigned int cellId2		);
 
+/* evaluate the cost change (new-old) of swapping two cells, floorplan is untouched	*/
+/* the trial result is kept in the floorplan scratch area for fpCommitSwap			*/
+int			 fpEvaluateSwap(floorplan *fp, unsigned int cellId1, unsigned int cellId2	);
+
+/* evaluate the cost change (new-old) of relocating a cell into an empty site (void);	*/
+/* only the moving cell nets are evaluated. Commit with fpCommitSwap					*/
+int			 fpEvaluateShift(floorplan *fp, unsigned int cellId, unsigned int voidId	);
+
+/* apply the last swap evaluated by fpEvaluateSwap and update the cost					*/
+void		 fpCommitSwap(floorplan *fp													);
+
+/* pick a random cell and a second one (or void) whose site is within 'rlim'			*/
+/* columns and rows from the first; the window is clipped to the floorplan				*/
+void		 fpRangeLimitedMove(floorplan *fp, unsigned int rlim,
+								unsigned int *cellId1, unsigned int *cellId2			);
+
+/* pick a move type by fp->moveProb (roulette)											*/
+unsigned int fpPickMoveType(floorplan *fp											);
+
+/* propose a move of the given type; the generator may fall back to another type.		*/
+/* Returns the type, counted as proposed												*/
+unsigned int fpProposeMoveOf(floorplan *fp, unsigned int moveType, unsigned int rlim,
+							 unsigned int *cellId1, unsigned int *cellId2				);
+
+/* move generator: pick a move type by fp->moveProb and propose a move of that type;	*/
+/* the first cell is never a void. Returns the move type, counted as proposed			*/
+unsigned int fpProposeMove(floorplan *fp, unsigned int rlim,
+						   unsigned int *cellId1, unsigned int *cellId2				);
+
+/* automatic initial temperature: 20 times the standard deviation of the cost change	*/
+/* of 'samplesN' random swaps evaluated from the current placement (same as VPR)		*/
+double		 fpAutoInitTemp(floorplan *fp, unsigned int samplesN							);
+
+/* zero-temperature greedy quench: sweep all cells, try swapping each with every site	*/
+/* within 'rlim' rows/columns and take improving swaps only, until a sweep finds none	*/
+/* returns the number of improving swaps												*/
+unsigned int fpQuench(floorplan *fp, unsigned int rlim									);
+
 /* simulated annealing placement 														*/
 void		 fpAnneal(floorplan *fp,  unsigned int movesPerTemp	, double initTemp		,
 									  double coolingRate		, double freezingTemp	);
 
+/* multi-start annealing: 'threadsN' independent annealers, each on a private copy of	*/
+/* the placement with its own random stream; the best final placement is kept in fp		*/
+void		 fpAnnealMultiStart(floorplan *fp, unsigned int threadsN,
+								unsigned int movesPerTemp, double initTemp,
+								double coolingRate		 , double freezingTemp			);
+
+/* parallel tempering (replica exchange): replicas, a rung every TEMPER_GAP of			*/
+/* log-temperature from initTemp (at most the cost change std-dev) to freezingTemp,		*/
+/* shared among 'threadsN' threads (TEMPER_THREADS if less than 2); neighbour rungs		*/
+/* exchange replicas by a Metropolis test after every round, and the rung spacing		*/
+/* adapts to the exchange ratios. The best placement of all replicas is kept in fp		*/
+void		 fpTemper(floorplan *fp, unsigned int threadsN,  unsigned int movesPerTemp,
+					  double initTemp, double coolingRate, double freezingTemp			);
+
+/* region-partitioned annealing: one cooling chain whose moves are split among			*/
+/* 'threadsN' threads (REGION_THREADS if less than 2), each moving cells only inside	*/
+/* its stripe of rows; stripes are merged and their boundaries shifted every			*/
+/* temperature. The best placement is kept in fp										*/
+void		 fpAnnealRegions(floorplan *fp, unsigned int threadsN, unsigned int movesPerTemp,
+							 double initTemp, double coolingRate, double freezingTemp	);
+
+/* speculative annealing: one cooling chain whose moves are evaluated in parallel		*/
+/* batches by 'threadsN' threads (SPEC_THREADS if less than 2) against the shared		*/
+/* placement; a serial phase commits them. A candidate that conflicts with a move		*/
+/* committed earlier in the batch is rejected and a new move is proposed on the			*/
+/* current placement in its place. The best placement is kept in fp						*/
+void		 fpAnnealSpeculative(floorplan *fp, unsigned int threadsN, unsigned int movesPerTemp,
+								 double initTemp, double coolingRate, double freezingTemp);
+
 #endif /* __FLOORPLAN_HEADER__ */
 
 
@@ -67,20 +67,32 @@ point		 index1Dto2D(unsigned int ix				,unsigned int nx,unsigned int ny){
 	return index2D;
 }
 
-/* returns bounding box half perimeter of points list									*/
-unsigned int pointsBBoxHalfPerimeter(point *points, unsigned int pointsNum				){
-	unsigned int pointi;
-	unsigned int dx,dy ;
-	unsigned int *xs = arrAlloc(pointsNum);
-	unsigned int *ys = arrAlloc(pointsNum);
-	for(pointi=0; pointi<pointsNum; pointi++) {
-		xs[pointi] = points[pointi].x;
-		ys[pointi] = points[pointi].y;
+/* move one coordinate of a point from 'from' to 'to' between min and max edges			*/
+/* returns 0 if the edges should be recomputed (the only point on an edge moved in)		*/
+static int	 edgesMoveCoord(unsigned int *min , unsigned int *max ,
+							unsigned int *minN, unsigned int *maxN,
+							unsigned int  from, unsigned int  to				){
+	if (to < from) { /* moving toward min edge */
+		if (from == *max) { /* leaving max edge */
+			if (*maxN == 1) return 0;
+			(*maxN)--;
+		}
+		if		(to <  *min) {*min=to; *minN=1;}
+		else if (to == *min) (*minN)++;
+	} else if (to > from) { /* moving toward max edge */
+		if (from == *min) { /* leaving min edge */
+			if (*minN == 1) return 0;
+			(*minN)--;
+		}
+		if		(to >  *max) {*max=to; *maxN=1;}
+		else if (to == *max) (*maxN)++;
 	}
-	dx = arrMax(xs,pointsNum)-arrMin(xs,pointsNum);
-	dy = arrMax(ys,pointsNum)-arrMin(ys,pointsNum);
-	safeFree(xs);
-	safeFree(ys);
+	return 1;
+}
 
-	return	dx+dy;
+/* move one point of a bounding box from 'from' to 'to' and update the box in O(1)		*/
+/* returns 0 if the box should be recomputed (the only point on an edge left it)		*/
+int			 boxMovePoint(box *bbox, point from, point to								){
+	return	edgesMoveCoord(&(bbox->xmin) ,&(bbox->xmax) ,&(bbox->xminN),&(bbox->xmaxN),from.x,to.x) &&
+			edgesMoveCoord(&(bbox->ymin) ,&(bbox->ymax) ,&(bbox->yminN),&(bbox->ymaxN),from.y,to.y)	;
 }
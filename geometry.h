@@ -45,6 +45,14 @@ struct pointStruct {
 };
 typedef struct pointStruct point;
 
+struct boxStruct {
+	unsigned int xmin, xmax;	/* x edges of the bounding box							*/
+	unsigned int ymin, ymax;	/* y edges of the bounding box							*/
+	unsigned int xminN, xmaxN;	/* amount of points on x edges, for incremental update	*/
+	unsigned int yminN, ymaxN;	/* amount of points on y edges, for incremental update	*/
+};
+typedef struct boxStruct box;
+
 
 /* change 2D index (ix,iy) in (nx,ny) size world into 1D linear world index				*/
 unsigned int index2Dto1D(unsigned int ix,unsigned int iy,unsigned int nx,unsigned int ny);
@@ -52,7 +60,8 @@ unsigned int index2Dto1D(unsigned int ix,unsigned int iy,unsigned int nx,unsigne
 /* change 1D linear world index ix into 2D index in (nx,ny) size world					*/
 point		 index1Dto2D(unsigned int ix				,unsigned int nx,unsigned int ny);
 
-/* returns bounding box half perimeter of points list									*/
-unsigned int pointsBBoxHalfPerimeter(point *points, unsigned int pointsNum				);
+/* move one point of a bounding box from 'from' to 'to' and update the box in O(1)		*/
+/* returns 0 if the box should be recomputed (the only point on an edge left it)		*/
+int			 boxMovePoint(box *bbox, point from, point to								);
 
 #endif /* __GEOMETRY_HEADER__															*/
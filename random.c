@@ -42,22 +42,65 @@
 #include <ctype.h>
 #include "random.h"
 
+/* random numbers generator state, private to each thread so that parallel annealers	*/
+/* neither share nor lock a sequence. Counter-based: the n-th number of a stream is a	*/
+/* hash of the stream key and n, so a seed and stream always give the same sequence		*/
+static __thread unsigned long long randKey	   = 0x2545F4914F6CDD1DULL;
+static __thread unsigned long long randCounter = 0;
+
+/* splitmix64 finalizer, a bijective 64-bit hash										*/
+static unsigned long long randMix(unsigned long long z									){
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/* returns the next random number of the calling thread in [0,RAND_MAX]					*/
+static unsigned int rand64(																){
+	randCounter++;
+	return (unsigned int)((randMix(randKey + randCounter*0x9E3779B97F4A7C15ULL) >> 33) % ((unsigned long long)RAND_MAX+1));
+}
+
+/* seed the random numbers generator of the calling thread; each 'stream' of the same	*/
+/* seed gives a different sequence, restarted from its first number						*/
+void		 setRandSeed(unsigned long seed, unsigned int stream						){
+	randKey		= randMix(randMix(seed) + (stream+1ULL)*0x9E3779B97F4A7C15ULL);
+	randCounter = 0;
+}
+
+/* save the random numbers generator state of the calling thread						*/
+void		 getRandState(randState *state												){
+	state->key	   = randKey;
+	state->counter = randCounter;
+}
+
+/* resume the random numbers generator of the calling thread from a saved state			*/
+void		 setRandState(randState *state												){
+	randKey		= state->key;
+	randCounter = state->counter;
+}
+
 /* returns a random number between minRand and maxRand [minRand,maxRand]				*/
 unsigned int getUIntRand(unsigned int minRand, unsigned int maxRand						){
-	/* random()								gives a random number in [0,RAND_MAX]		*/
-	/* random()%maxRand						gives a random number between [0,maxRand-1]	*/
-	/* random()%(maxRand-minRan+1)			gives a random number in [0,maxRand-minRand]*/
-	/* random()%(maxRand-minRan+1)+minRand	gives a random number in [minRand,maxRand]	*/
-	return ( random() % (maxRand - minRand + 1) ) + minRand;
+	/* rand64()								gives a random number in [0,RAND_MAX]		*/
+	/* rand64()%maxRand						gives a random number between [0,maxRand-1]	*/
+	/* rand64()%(maxRand-minRan+1)			gives a random number in [0,maxRand-minRand]*/
+	/* rand64()%(maxRand-minRan+1)+minRand	gives a random number in [minRand,maxRand]	*/
+	return ( rand64() % (maxRand - minRand + 1) ) + minRand;
 }
 
 /* returns a random number between minRand and maxRand [minRand,maxRand]				*/
 float		 getFloatRand(float minRand, float maxRand									){
-  /* random()										random number in [0,RAND_MAX]		*/
-  /* random()/RAND_MAX								random number between [0,1]			*/
-  /* (random()/RAND_MAX)*(maxRand-minRand)			random number in [0,maxRand-minRand]*/
-  /* (random()/RAND_MAX)*(maxRand-minRand)+minRand	random number in [minRand,maxRand]	*/
-  return ((float)random()/RAND_MAX)*(maxRand-minRand)+minRand;
+  /* rand64()										random number in [0,RAND_MAX]		*/
+  /* rand64()/RAND_MAX								random number between [0,1]			*/
+  /* (rand64()/RAND_MAX)*(maxRand-minRand)			random number in [0,maxRand-minRand]*/
+  /* (rand64()/RAND_MAX)*(maxRand-minRand)+minRand	random number in [minRand,maxRand]	*/
+  return ((float)rand64()/RAND_MAX)*(maxRand-minRand)+minRand;
+}
+
+/* returns a raw random number in [0,RAND_MAX]											*/
+unsigned int getRawRand(																){
+	return rand64();
 }
 
 /* returns two different random numbers between minRand and maxRand [minRand,maxRand]	*/
@@ -36,12 +36,32 @@
 #define __RANDOM_HEADER__
 
 
+/* random numbers generator state, to resume a sequence after an unrelated draw			*/
+struct randStateStruct {
+	unsigned long long key;		/* stream key											*/
+	unsigned long long counter;	/* numbers drawn from the stream						*/
+};
+typedef struct randStateStruct randState;
+
+/* seed the random numbers generator of the calling thread; each 'stream' of the same	*/
+/* seed gives a different sequence														*/
+void		 setRandSeed(unsigned long seed, unsigned int stream						);
+
+/* save the random numbers generator state of the calling thread						*/
+void		 getRandState(randState *state												);
+
+/* resume the random numbers generator of the calling thread from a saved state			*/
+void		 setRandState(randState *state												);
+
 /* returns a random number between minRand and maxRand [minRand,maxRand]				*/
 unsigned int getUIntRand(unsigned int minRand, unsigned int maxRand						);
 
 /* returns a random number between minRand and maxRand [minRand,maxRand]				*/
 float		 getFloatRand(float minRand, float maxRand									);
 
+/* returns a raw random number in [0,RAND_MAX]											*/
+unsigned int getRawRand(																);
+
 /* returns two different random numbers between minRand and maxRand [minRand,maxRand]	*/
 void		 get2DiffUIntRand(	unsigned int *rand1  , unsigned int *rand2				,
 							unsigned int  minRand, unsigned int  maxRand				);